@@ -0,0 +1,109 @@
+﻿#include "BatchTranslator.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+BatchTranslator::BatchTranslator(TranslationEngine* engine, DocumentCache* cache, QObject* parent)
+    : QObject(parent)
+    , engine(engine)
+    , cache(cache)
+    , active(false)
+{
+    connect(engine, &TranslationEngine::documentTranslationFinished,
+        this, &BatchTranslator::onDocumentFinished);
+    connect(engine, &TranslationEngine::errorOccurred, this, &BatchTranslator::onError);
+}
+
+void BatchTranslator::start(const QStringList& inputFiles, const QString& outputDirectory)
+{
+    pending = inputFiles;
+    this->outputDirectory = outputDirectory;
+    QDir().mkpath(outputDirectory);
+    QMetaObject::invokeMethod(this, &BatchTranslator::processNext, Qt::QueuedConnection);
+}
+
+QString BatchTranslator::outputPathFor(const QString& inputFile, const QString& outputDirectory,
+    const QString& targetLang)
+{
+    return QDir(outputDirectory).filePath(
+        QFileInfo(inputFile).completeBaseName() + "_" + targetLang + ".txt");
+}
+
+void BatchTranslator::processNext()
+{
+    while (!pending.isEmpty()) {
+        currentInput = pending.takeFirst();
+        const TranslationOptions options = engine->currentOptions();
+        currentOutput = outputPathFor(currentInput, outputDirectory, options.targetLang);
+        timer.start();
+
+        // 缓存位于读取文件之前：只对原始字节求摘要
+        const QByteArray fingerprint = cache->fingerprint(currentInput);
+        if (fingerprint.isEmpty()) {
+            emit fileFailed(currentInput, "无法读取文件");
+            continue;
+        }
+        const QString format = fileHandler.getFormatExtension(fileHandler.detectFormat(currentInput));
+        currentKey = DocumentCache::makeKey(fingerprint, format, options,
+            engine->glossaryVersion(options.domain));
+
+        const QString cached = cache->lookup(currentKey);
+        if (!cached.isEmpty()) {
+            QFile::remove(currentOutput);
+            if (QFile::copy(cached, currentOutput)) {
+                emit fileFinished(currentInput, currentOutput, true, timer.nsecsElapsed() / 1.0e6);
+                continue;
+            }
+            // 缓存文件已被外部删除，按未命中处理
+            cache->remove(currentKey);
+        }
+
+        QString content;
+        if (!fileHandler.readFile(currentInput, content)) {
+            emit fileFailed(currentInput, "无法读取文件（文件不存在或编码无法识别）");
+            continue;
+        }
+        engine->loadDocument(std::move(content));
+        if (engine->segmentStore()->count() == 0) {
+            // 空文档不经过引擎，直接写出空的输出文件
+            if (!fileHandler.writeFile(currentOutput, QString())) {
+                emit fileFailed(currentInput, "无法写入文件: " + currentOutput);
+                continue;
+            }
+            cache->store(currentKey, currentOutput);
+            emit fileFinished(currentInput, currentOutput, false, timer.nsecsElapsed() / 1.0e6);
+            continue;
+        }
+
+        active = true;
+        engine->translateDocument(currentOutput);
+        return;
+    }
+
+    emit finished();
+}
+
+void BatchTranslator::onDocumentFinished()
+{
+    if (!active) {
+        return;
+    }
+    active = false;
+
+    cache->store(currentKey, currentOutput);
+    emit fileFinished(currentInput, currentOutput, false, timer.nsecsElapsed() / 1.0e6);
+    QMetaObject::invokeMethod(this, &BatchTranslator::processNext, Qt::QueuedConnection);
+}
+
+void BatchTranslator::onError(const QString& error)
+{
+    if (!active) {
+        return;
+    }
+    active = false;
+
+    // 停止当前文档的剩余请求，继续下一个文件
+    engine->cancelTranslation();
+    emit fileFailed(currentInput, error);
+    QMetaObject::invokeMethod(this, &BatchTranslator::processNext, Qt::QueuedConnection);
+}
\ No newline at end of file
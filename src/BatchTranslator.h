@@ -0,0 +1,50 @@
+﻿#ifndef BATCHTRANSLATOR_H
+#define BATCHTRANSLATOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "TranslationEngine.h"
+#include "FileHandler.h"
+#include "DocumentCache.h"
+
+// 逐个把文件翻译为输出文件：先按原始文件内容查文档缓存，命中时直接复制缓存的输出，
+// 不读取、不解码、不分段；未命中时走完整流程，完成后把输出写入缓存
+class BatchTranslator : public QObject
+{
+    Q_OBJECT
+
+public:
+    BatchTranslator(TranslationEngine* engine, DocumentCache* cache, QObject* parent = nullptr);
+
+    void start(const QStringList& inputFiles, const QString& outputDirectory);
+    // 输出文件名：<原文件名>_<目标语言>.txt
+    static QString outputPathFor(const QString& inputFile, const QString& outputDirectory,
+        const QString& targetLang);
+
+signals:
+    void fileFinished(const QString& inputFile, const QString& outputFile, bool fromCache,
+        double elapsedMs);
+    void fileFailed(const QString& inputFile, const QString& error);
+    void finished();
+
+private slots:
+    void processNext();
+    void onDocumentFinished();
+    void onError(const QString& error);
+
+private:
+    TranslationEngine* engine;
+    DocumentCache* cache;
+    FileHandler fileHandler;
+
+    QStringList pending;
+    QString outputDirectory;
+    QString currentInput;
+    QString currentOutput;
+    QString currentKey;
+    QElapsedTimer timer;
+    bool active;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,351 @@
+﻿#include "DocumentCache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const char* const kEntrySuffix = ".out";
+    const qint64 kCopyChunkSize = 1024 * 1024;
+    // 文件摘要的持久化记录，与条目放在同一目录
+    const char* const kFingerprintFile = "fingerprints.idx";
+    const quint32 kFingerprintMagic = 0x54544650;
+    const quint32 kFingerprintVersion = 2;
+    // 保存时只保留最近使用的记录
+    const int kMaxFingerprints = 10000;
+    // 文件系统时间戳的最大粒度（FAT为2秒）
+    const qint64 kTimestampGranularityMs = 2000;
+}
+
+DocumentCache::DocumentCache(const QString& directory, qint64 maxBytes)
+    : directory(directory)
+    , maxBytes(maxBytes)
+    , usedBytes(0)
+    , clock(0)
+    , indexLoaded(false)
+    , fingerprintsChanged(false)
+{
+}
+
+DocumentCache::~DocumentCache()
+{
+    QMutexLocker locker(&mutex);
+    saveFingerprints();
+}
+
+QString DocumentCache::defaultDirectory()
+{
+    // 不使用CacheLocation：它随应用名变化，而界面和命令行模式的应用名不同，
+    // 固定目录才能让任务队列与批量翻译共用同一份缓存
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + "/TranslationTool/documents";
+}
+
+void DocumentCache::preload()
+{
+    QMutexLocker locker(&mutex);
+    ensureIndex();
+}
+
+QByteArray DocumentCache::fingerprint(const QString& filePath)
+{
+    const QString path = QFileInfo(filePath).absoluteFilePath();
+    FileStamp stamp;
+    if (!readStamp(path, stamp)) {
+        return QByteArray();
+    }
+    {
+        QMutexLocker locker(&mutex);
+        ensureIndex();
+        auto it = fingerprints.find(path);
+        // 保留修改时间的复制（cp -p、rsync -t、touch -r）会更新ctime和inode，
+        // 求摘要后在同一时间粒度内的写入则由hashedAt排除
+        if (it != fingerprints.end() && sameFile(*it, stamp)
+            && it->changed + kTimestampGranularityMs < it->hashedAt) {
+            it->lastUsed = ++clock;
+            return it->digest;
+        }
+    }
+
+    stamp.hashedAt = QDateTime::currentMSecsSinceEpoch();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    stamp.digest = hash.result();
+
+    // 求摘要期间文件被修改时摘要仍可用于本次，但不记录
+    FileStamp after;
+    if (!readStamp(path, after) || !sameFile(stamp, after)) {
+        return stamp.digest;
+    }
+
+    QMutexLocker locker(&mutex);
+    stamp.lastUsed = ++clock;
+    fingerprints.insert(path, stamp);
+    fingerprintsChanged = true;
+    return stamp.digest;
+}
+
+bool DocumentCache::readStamp(const QString& path, FileStamp& stamp)
+{
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return false;
+    }
+    stamp.size = info.size();
+    stamp.modified = info.lastModified().toMSecsSinceEpoch();
+    stamp.changed = info.metadataChangeTime().toMSecsSinceEpoch();
+    stamp.inode = 0;
+#ifdef Q_OS_UNIX
+    struct stat status;
+    if (::stat(QFile::encodeName(path).constData(), &status) == 0) {
+        stamp.inode = static_cast<quint64>(status.st_ino);
+    }
+#endif
+    return true;
+}
+
+bool DocumentCache::sameFile(const FileStamp& a, const FileStamp& b)
+{
+    return a.size == b.size && a.modified == b.modified && a.changed == b.changed
+        && a.inode == b.inode;
+}
+
+QString DocumentCache::makeKey(const QByteArray& fingerprint, const QString& format,
+    const TranslationOptions& options, const QString& glossaryVersion)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(fingerprint);
+    const QString settings = QString("\x1f%1\x1f%2\x1f%3\x1f%4\x1f%5")
+        .arg(format.toLower(), options.sourceLang, options.targetLang)
+        .arg(static_cast<int>(options.domain))
+        .arg(glossaryVersion);
+    hash.addData(settings.toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString DocumentCache::lookup(const QString& key)
+{
+    QMutexLocker locker(&mutex);
+    ensureIndex();
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return QString();
+    }
+    it->lastUsed = ++clock;
+    const QString path = entryPath(key);
+    locker.unlock();
+
+    // 下次启动时按修改时间恢复使用顺序，命中时更新修改时间，淘汰才是按最近使用
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    return path;
+}
+
+bool DocumentCache::store(const QString& key, const QString& outputFile)
+{
+    const qint64 bytes = QFileInfo(outputFile).size();
+    {
+        QMutexLocker locker(&mutex);
+        ensureIndex();
+        if (bytes > maxBytes) {
+            return false;
+        }
+    }
+
+    // 复制到缓存目录中唯一命名的临时文件再原子替换，同一条目被多个线程或进程
+    // 同时写入时互不干扰，读取方也不会看到复制了一半的条目
+    const QString path = entryPath(key);
+    QFile source(outputFile);
+    QSaveFile target(path);
+    if (!source.open(QIODevice::ReadOnly) || !target.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入文档缓存:" << path;
+        return false;
+    }
+    QByteArray chunk;
+    while (!(chunk = source.read(kCopyChunkSize)).isEmpty()) {
+        if (target.write(chunk) != chunk.size()) {
+            target.cancelWriting();
+            break;
+        }
+    }
+    if (source.error() != QFileDevice::NoError) {
+        target.cancelWriting();
+    }
+    if (!target.commit()) {
+        qDebug() << "无法写入文档缓存:" << path << target.errorString();
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        usedBytes -= it->bytes;
+    }
+    entries.insert(key, { bytes, ++clock });
+    usedBytes += bytes;
+    evict();
+    return true;
+}
+
+void DocumentCache::remove(const QString& key)
+{
+    QMutexLocker locker(&mutex);
+    ensureIndex();
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    usedBytes -= it->bytes;
+    entries.erase(it);
+    QFile::remove(entryPath(key));
+}
+
+void DocumentCache::setMaxBytes(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    ensureIndex();
+    maxBytes = bytes;
+    evict();
+}
+
+qint64 DocumentCache::totalBytes()
+{
+    QMutexLocker locker(&mutex);
+    ensureIndex();
+    return usedBytes;
+}
+
+QString DocumentCache::entryPath(const QString& key) const
+{
+    return directory + "/" + key + kEntrySuffix;
+}
+
+void DocumentCache::ensureIndex()
+{
+    if (indexLoaded) {
+        return;
+    }
+    indexLoaded = true;
+    QDir().mkpath(directory);
+    loadIndex();
+    loadFingerprints();
+}
+
+void DocumentCache::loadIndex()
+{
+    // 按修改时间从旧到新编号，作为上次运行留下的使用顺序
+    QFileInfoList files = QDir(directory).entryInfoList(
+        { QString("*") + kEntrySuffix }, QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QFileInfo& info : files) {
+        entries.insert(info.completeBaseName(), { info.size(), ++clock });
+        usedBytes += info.size();
+    }
+    evict();
+}
+
+void DocumentCache::loadFingerprints()
+{
+    // 上次运行的摘要：文件状态未变的文件不再重新求摘要
+    QFile file(directory + "/" + kFingerprintFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kFingerprintMagic || version != kFingerprintVersion || count < 0) {
+        return;
+    }
+
+    for (qint32 i = 0; i < count; ++i) {
+        QString path;
+        FileStamp stamp;
+        in >> path >> stamp.size >> stamp.modified >> stamp.changed >> stamp.inode
+            >> stamp.hashedAt >> stamp.digest;
+        if (in.status() != QDataStream::Ok) {
+            // 文件损坏时丢弃全部记录，按需重新求摘要
+            fingerprints.clear();
+            return;
+        }
+        stamp.lastUsed = ++clock;
+        fingerprints.insert(path, stamp);
+    }
+}
+
+void DocumentCache::saveFingerprints()
+{
+    if (!fingerprintsChanged || !indexLoaded) {
+        return;
+    }
+
+    QVector<QPair<qint64, QString>> order;
+    order.reserve(fingerprints.size());
+    for (auto it = fingerprints.constBegin(); it != fingerprints.constEnd(); ++it) {
+        order.append({ it->lastUsed, it.key() });
+    }
+    std::sort(order.begin(), order.end(), std::greater<>());
+    if (order.size() > kMaxFingerprints) {
+        order.resize(kMaxFingerprints);
+    }
+
+    QSaveFile file(directory + "/" + kFingerprintFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法保存文件摘要:" << file.fileName();
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kFingerprintMagic << kFingerprintVersion << qint32(order.size());
+    for (const auto& item : order) {
+        const FileStamp& stamp = fingerprints[item.second];
+        out << item.second << stamp.size << stamp.modified << stamp.changed << stamp.inode
+            << stamp.hashedAt << stamp.digest;
+    }
+    if (file.commit()) {
+        fingerprintsChanged = false;
+    }
+}
+
+void DocumentCache::evict()
+{
+    if (usedBytes <= maxBytes) {
+        return;
+    }
+
+    QVector<QPair<qint64, QString>> order;
+    order.reserve(entries.size());
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        order.append({ it->lastUsed, it.key() });
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const auto& item : order) {
+        if (usedBytes <= maxBytes) {
+            break;
+        }
+        usedBytes -= entries.value(item.second).bytes;
+        entries.remove(item.second);
+        QFile::remove(entryPath(item.second));
+    }
+}
\ No newline at end of file
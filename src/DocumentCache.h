@@ -0,0 +1,80 @@
+﻿#ifndef DOCUMENTCACHE_H
+#define DOCUMENTCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include "TranslationBackend.h"
+
+// 整篇文档的译文缓存：键由原始文件内容的摘要、格式、语言对、领域和词典版本组成，
+// 值为完整的输出文件。索引常驻内存，命中时不读取、不解码原文件；
+// 磁盘占用超过上限时按最近使用淘汰。
+// 构造时不访问磁盘，索引和文件摘要记录在preload或第一次使用时加载，析构时保存摘要记录
+class DocumentCache
+{
+public:
+    explicit DocumentCache(const QString& directory = defaultDirectory(),
+        qint64 maxBytes = 1024LL * 1024 * 1024);
+    ~DocumentCache();
+
+    static QString defaultDirectory();
+    // 扫描缓存目录建立索引，可在后台线程提前调用
+    void preload();
+
+    // 原始文件字节的摘要；路径、大小、修改时间、ctime和inode都未变时
+    // 直接复用之前（包括上次运行）的结果
+    QByteArray fingerprint(const QString& filePath);
+    static QString makeKey(const QByteArray& fingerprint, const QString& format,
+        const TranslationOptions& options, const QString& glossaryVersion);
+
+    // 命中时返回缓存的输出文件路径，否则返回空
+    QString lookup(const QString& key);
+    // 把已完成的输出文件复制进缓存
+    bool store(const QString& key, const QString& outputFile);
+    // 缓存文件被外部删除等情况下移除条目
+    void remove(const QString& key);
+
+    void setMaxBytes(qint64 bytes);
+    qint64 totalBytes();
+
+private:
+    struct Entry {
+        qint64 bytes = 0;
+        qint64 lastUsed = 0;
+    };
+    // 求摘要时文件的状态：大小、修改时间、状态变化时间（ctime）和inode都未变才复用摘要
+    struct FileStamp {
+        qint64 size = 0;
+        qint64 modified = 0;
+        qint64 changed = 0;
+        quint64 inode = 0;
+        // 求摘要的时间；ctime与之过近时同一时间粒度内可能还有写入，不复用
+        qint64 hashedAt = 0;
+        QByteArray digest;
+        qint64 lastUsed = 0;
+    };
+
+    QString entryPath(const QString& key) const;
+    static bool readStamp(const QString& path, FileStamp& stamp);
+    static bool sameFile(const FileStamp& a, const FileStamp& b);
+    // 调用时须持有mutex
+    void ensureIndex();
+    void loadIndex();
+    void loadFingerprints();
+    void saveFingerprints();
+    void evict();
+
+    mutable QMutex mutex;
+    QString directory;
+    qint64 maxBytes;
+    qint64 usedBytes;
+    // 内存中的访问序号，启动时按文件修改时间初始化
+    qint64 clock;
+    bool indexLoaded;
+    bool fingerprintsChanged;
+    QHash<QString, Entry> entries;
+    QHash<QString, FileStamp> fingerprints;
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,59 @@
 ﻿#include "FileHandler.h"
+#include "OrderedFileWriter.h"
+#include "MappedTextReader.h"
 #include <QFile>
 #include <QTextStream>
 #include <QFileInfo>
 #include <QDebug>
-#include <QRegularExpression>
+
+namespace {
+    // 流式清理文本，与按块解码配合，不需要先得到完整的原文：
+    // - ASCII空白（空格和\t\n\v\f\r）连续出现时合并为一个空格
+    // - 移除其他控制字符；控制字符两侧的空白各自保留
+    // - 去掉首尾的空白（包括全角空格等Unicode空白）
+    class TextCleaner
+    {
+    public:
+        explicit TextCleaner(QString& output)
+            : output(output)
+            , inSpaceRun(false)
+        {
+        }
+
+        void append(QStringView chunk)
+        {
+            for (QChar c : chunk) {
+                const char16_t code = c.unicode();
+                if (code == u' ' || (code >= 0x09 && code <= 0x0D)) {
+                    if (!inSpaceRun && !output.isEmpty()) {
+                        trailing += QLatin1Char(' ');
+                    }
+                    inSpaceRun = true;
+                    continue;
+                }
+                inSpaceRun = false;
+                if (code <= 0x08 || (code >= 0x0E && code <= 0x1F)) {
+                    continue;
+                }
+                if (c.isSpace()) {
+                    if (!output.isEmpty()) {
+                        trailing += c;
+                    }
+                    continue;
+                }
+                // 空白暂存到下一个正文字符之前写出，开头和结尾的空白因此被去掉
+                output += trailing;
+                trailing.clear();
+                output += c;
+            }
+        }
+
+    private:
+        QString& output;
+        QString trailing;
+        bool inSpaceRun;
+    };
+}
 
 FileHandler::FileHandler(QObject* parent)
     : QObject(parent)
@@ -12,13 +62,8 @@ FileHandler::FileHandler(QObject* parent)
 
 bool FileHandler::readFile(const QString& filePath, QString& content)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "无法打开文件:" << filePath << file.errorString();
-        return false;
-    }
-
     FileFormat format = detectFormat(filePath);
+    lastEncoding.clear();
 
     switch (format) {
     case FileFormat::TXT:
@@ -26,13 +71,25 @@ bool FileHandler::readFile(const QString& filePath, QString& content)
     case FileFormat::XML:
     case FileFormat::JSON:
     {
-        QTextStream stream(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        stream.setCodec("UTF-8");
-#else
-        stream.setEncoding(QStringConverter::Utf8);
-#endif
-        content = stream.readAll();
+        // 内存映射读取，识别编码后分块解码，每块解码后立即清理并追加到结果中，
+        // 不保留未清理的完整原文；编码不符的文件在此直接失败
+        MappedTextReader reader(filePath);
+        if (!reader.open()) {
+            qDebug() << "无法读取文件:" << filePath << reader.errorString();
+            return false;
+        }
+        content.clear();
+        content.reserve(reader.decodedLength());
+        TextCleaner cleaner(content);
+        const bool decoded = reader.decode([&cleaner](QStringView chunk) {
+            cleaner.append(chunk);
+            return true;
+        });
+        if (!decoded) {
+            qDebug() << "无法读取文件:" << filePath << reader.errorString();
+            return false;
+        }
+        lastEncoding = reader.encodingName();
         break;
     }
     case FileFormat::DOCX:
@@ -43,32 +100,25 @@ bool FileHandler::readFile(const QString& filePath, QString& content)
         content = "不支持的格式";
         return false;
     }
-
-    file.close();
-
-    // 清理文本
-    content = cleanText(content);
     return true;
 }
 
 bool FileHandler::writeFile(const QString& filePath, const QString& content)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qDebug() << "无法写入文件:" << filePath << file.errorString();
+    // 先写临时文件再原子替换，写入失败不会破坏已有文件
+    OrderedFileWriter writer(filePath);
+    writer.setExpectedCount(1);
+    if (!writer.open()) {
+        qDebug() << "无法写入文件:" << filePath << writer.errorString();
         return false;
     }
 
-    QTextStream stream(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    stream.setCodec("UTF-8");
-#else
-    stream.setEncoding(QStringConverter::Utf8);
-#endif
-    stream << content;
+    return writer.write(0, content) && writer.commit();
+}
 
-    file.close();
-    return true;
+QString FileHandler::detectedEncoding() const
+{
+    return lastEncoding;
 }
 
 FileFormat FileHandler::detectFormat(const QString& filePath)
@@ -139,18 +189,12 @@ bool FileHandler::preserveFormatting(const QString& sourcePath, const QString& t
     return writeFile(targetPath, translatedContent);
 }
 
-QString FileHandler::cleanText(const QString& text)
+QString FileHandler::cleanText(QString text)
 {
-    QString result = text;
-
-    // 移除多余的空格和换行
-    result.replace(QRegularExpression("\\s+"), " ");
-    result.replace(QRegularExpression("\\n\\s*\\n"), "\n\n");
-
-    // 清理不可见字符（保留基本的空白字符）
-    result.remove(QRegularExpression("[\\x00-\\x08\\x0B-\\x0C\\x0E-\\x1F]"));
-
-    return result.trimmed();
+    QString result;
+    result.reserve(text.size());
+    TextCleaner(result).append(text);
+    return result;
 }
 
 bool FileHandler::isBinaryFormat(FileFormat format)
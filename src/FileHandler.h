@@ -26,6 +26,8 @@ public:
 
     bool readFile(const QString& filePath, QString& content);
     bool writeFile(const QString& filePath, const QString& content);
+    // 最近一次readFile识别出的文本编码
+    QString detectedEncoding() const;
     FileFormat detectFormat(const QString& filePath);
     QString getFormatExtension(FileFormat format);
 
@@ -36,8 +38,10 @@ public:
         const QString& translatedContent);
 
 private:
-    QString cleanText(const QString& text);
+    QString cleanText(QString text);
     bool isBinaryFormat(FileFormat format);
+
+    QString lastEncoding;
 };
 
 #endif
\ No newline at end of file
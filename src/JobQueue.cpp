@@ -0,0 +1,527 @@
+﻿#include "JobQueue.h"
+#include "OrderedFileWriter.h"
+#include "FileHandler.h"
+#include "StartupTrace.h"
+#include "TranslationConstants.h"
+#include <QFile>
+#include <QFileInfo>
+
+using namespace TranslationConstants;
+
+namespace {
+    // 同时持有原文的未完成任务数上限（暂停的任务释放原文，不计入）
+    const int kMaxOpenJobs = 4;
+}
+
+struct JobQueue::Job {
+    int id = 0;
+    QString inputFile;
+    QString outputFile;
+    TranslationOptions options;
+    int priority = 0;
+    State state = State::Queued;
+    int progress = 0;
+    bool fromCache = false;
+    bool removed = false;
+    QString error;
+
+    // 打开之前按文件大小估计，打开后为原文字符数；剩余量按进度折算
+    qint64 totalChars = 0;
+    bool opening = false;
+    // 没有可领取的请求；进行中的请求全部完成后任务结束
+    bool exhausted = false;
+    int inFlight = 0;
+    QByteArray fingerprint;
+    QString cacheKey;
+
+    // 打开后由引擎规划的文档任务，暂停且空闲时释放；
+    // 输出文件保留已写入的分段，继续时据此重新规划
+    TranslationEngine::DocumentJobPtr document;
+    std::shared_ptr<OrderedFileWriter> writer;
+
+    qint64 remainingChars() const
+    {
+        return totalChars * (100 - progress) / 100;
+    }
+};
+
+JobQueue::JobQueue(TranslationEngine* engine, DocumentCache* cache, QObject* parent)
+    : QObject(parent)
+    , engine(engine)
+    , cache(cache)
+    , nextId(1)
+    , foregroundId(0)
+    , activeWorkers(1)
+    , stopping(false)
+{
+    // 文档缓存的索引在后台加载，界面不等待；加载完成前的查询在缓存内部等待
+    engine->startOnWorkerPool([this]() {
+        {
+            StartupTrace::Scope scope("加载文档缓存索引");
+            this->cache->preload();
+        }
+        QMutexLocker locker(&mutex);
+        --activeWorkers;
+        idle.wakeAll();
+    }, kDocumentPriority);
+}
+
+JobQueue::~JobQueue()
+{
+    QMutexLocker locker(&mutex);
+    stopping = true;
+    // 等待内存预算的写入立即返回，已发出的请求完成后工作线程退出；
+    // 未完成任务的临时文件随任务释放而丢弃
+    for (const JobPtr& job : jobMap) {
+        if (job->document) {
+            TranslationEngine::cancelDocument(job->document);
+        }
+    }
+    while (activeWorkers > 0) {
+        idle.wait(&mutex);
+    }
+}
+
+int JobQueue::addJob(const QString& inputFile, const QString& outputFile,
+    const TranslationOptions& options, int priority)
+{
+    auto job = std::make_shared<Job>();
+    job->inputFile = inputFile;
+    job->outputFile = outputFile;
+    job->options = options;
+    job->priority = priority;
+    job->totalChars = QFileInfo(inputFile).size();
+
+    int id = 0;
+    {
+        QMutexLocker locker(&mutex);
+        id = nextId++;
+        job->id = id;
+        jobMap.insert(id, job);
+    }
+
+    emit jobChanged(id);
+    startWorkers();
+    return id;
+}
+
+void JobQueue::pauseJob(int id)
+{
+    {
+        QMutexLocker locker(&mutex);
+        JobPtr job = jobMap.value(id);
+        if (!job || (job->state != State::Queued && job->state != State::Running)) {
+            return;
+        }
+        job->state = State::Paused;
+        suspendIfIdle(*job);
+    }
+    emit jobChanged(id);
+    // 暂停的任务不再占用打开名额，其他任务可以开始
+    startWorkers();
+}
+
+void JobQueue::resumeJob(int id)
+{
+    {
+        QMutexLocker locker(&mutex);
+        JobPtr job = jobMap.value(id);
+        if (!job || job->state != State::Paused) {
+            return;
+        }
+        job->state = job->document ? State::Running : State::Queued;
+    }
+    emit jobChanged(id);
+    startWorkers();
+}
+
+void JobQueue::setPriority(int id, int priority)
+{
+    {
+        QMutexLocker locker(&mutex);
+        JobPtr job = jobMap.value(id);
+        if (!job) {
+            return;
+        }
+        job->priority = priority;
+    }
+    emit jobChanged(id);
+}
+
+void JobQueue::setForegroundJob(int id)
+{
+    int previous = 0;
+    {
+        QMutexLocker locker(&mutex);
+        previous = foregroundId;
+        foregroundId = jobMap.contains(id) ? id : 0;
+    }
+    if (previous != 0) {
+        emit jobChanged(previous);
+    }
+    if (id != 0) {
+        emit jobChanged(id);
+    }
+    startWorkers();
+}
+
+void JobQueue::removeJob(int id)
+{
+    {
+        QMutexLocker locker(&mutex);
+        JobPtr job = jobMap.take(id);
+        if (!job) {
+            return;
+        }
+        // 进行中的请求不再写入，其引用释放后临时文件随之删除
+        job->removed = true;
+        if (job->document) {
+            TranslationEngine::cancelDocument(job->document);
+        }
+        job->document.reset();
+        job->writer.reset();
+        if (foregroundId == id) {
+            foregroundId = 0;
+        }
+    }
+    emit jobRemoved(id);
+    startWorkers();
+}
+
+QList<JobQueue::JobInfo> JobQueue::jobs() const
+{
+    QMutexLocker locker(&mutex);
+    QList<JobInfo> infos;
+    for (const JobPtr& job : jobMap) {
+        infos.append(snapshot(*job));
+    }
+    return infos;
+}
+
+JobQueue::JobInfo JobQueue::job(int id) const
+{
+    QMutexLocker locker(&mutex);
+    JobPtr job = jobMap.value(id);
+    return job ? snapshot(*job) : JobInfo();
+}
+
+JobQueue::JobInfo JobQueue::snapshot(const Job& job) const
+{
+    JobInfo info;
+    info.id = job.id;
+    info.inputFile = job.inputFile;
+    info.outputFile = job.outputFile;
+    info.options = job.options;
+    info.priority = job.priority;
+    info.state = job.state;
+    info.progress = job.progress;
+    info.foreground = job.id == foregroundId;
+    info.fromCache = job.fromCache;
+    info.error = job.error;
+    return info;
+}
+
+void JobQueue::startWorkers()
+{
+    QMutexLocker locker(&mutex);
+    startWorkersLocked();
+}
+
+void JobQueue::startWorkersLocked()
+{
+    // 没有可领取的工作时任务立即结束，多提交几个不会占用线程池
+    while (!stopping && activeWorkers < engine->maxConcurrency()) {
+        ++activeWorkers;
+        engine->startOnWorkerPool([this]() {
+            runWorker();
+        }, kDocumentPriority);
+    }
+}
+
+void JobQueue::runWorker()
+{
+    JobPtr job;
+    bool open = false;
+    bool found = false;
+    {
+        QMutexLocker locker(&mutex);
+        found = !stopping && takeWork(job, open);
+    }
+
+    if (found) {
+        if (open) {
+            openJob(job);
+        }
+        else {
+            runUnit(job);
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    --activeWorkers;
+    // 重新提交而不是循环领取，界面文档的工作单元可以在两个请求之间插入
+    if (found) {
+        startWorkersLocked();
+    }
+    idle.wakeAll();
+}
+
+bool JobQueue::isBetter(const Job& a, const Job& b) const
+{
+    const bool aForeground = a.id == foregroundId;
+    const bool bForeground = b.id == foregroundId;
+    if (aForeground != bForeground) {
+        return aForeground;
+    }
+    if (a.priority != b.priority) {
+        return a.priority > b.priority;
+    }
+    // 短任务优先，尽早产出完整的文件
+    if (a.remainingChars() != b.remainingChars()) {
+        return a.remainingChars() < b.remainingChars();
+    }
+    return a.id < b.id;
+}
+
+bool JobQueue::takeWork(JobPtr& job, bool& open)
+{
+    int openJobs = 0;
+    for (const JobPtr& candidate : jobMap) {
+        if ((candidate->opening || candidate->document)
+            && (candidate->state == State::Queued || candidate->state == State::Running)) {
+            ++openJobs;
+        }
+    }
+
+    JobPtr best;
+    for (const JobPtr& candidate : jobMap) {
+        if (candidate->state != State::Queued && candidate->state != State::Running) {
+            continue;
+        }
+        if (candidate->opening || (candidate->document && candidate->exhausted)) {
+            continue;
+        }
+        if (!candidate->document && openJobs >= kMaxOpenJobs) {
+            continue;
+        }
+        if (!best || isBetter(*candidate, *best)) {
+            best = candidate;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+
+    job = best;
+    open = !best->document;
+    if (open) {
+        best->opening = true;
+    }
+    else {
+        ++best->inFlight;
+        best->state = State::Running;
+    }
+    return true;
+}
+
+void JobQueue::openJob(const JobPtr& job)
+{
+    std::shared_ptr<OrderedFileWriter> writer;
+    QByteArray previousFingerprint;
+    {
+        QMutexLocker locker(&mutex);
+        writer = job->writer;
+        previousFingerprint = job->fingerprint;
+    }
+
+    // 文档缓存位于读取文件之前，命中时不读取、不解码
+    const QByteArray fingerprint = cache->fingerprint(job->inputFile);
+    if (fingerprint.isEmpty()) {
+        failJob(job, "无法读取文件");
+        return;
+    }
+    if (writer && fingerprint != previousFingerprint) {
+        // 暂停期间原文件被修改，已写入的分段作废
+        writer.reset();
+    }
+
+    FileHandler fileHandler;
+    QString cacheKey;
+    if (!writer) {
+        const QString format = fileHandler.getFormatExtension(fileHandler.detectFormat(job->inputFile));
+        cacheKey = DocumentCache::makeKey(fingerprint, format, job->options,
+            engine->glossaryVersion(job->options.domain));
+
+        const QString cached = cache->lookup(cacheKey);
+        if (!cached.isEmpty()) {
+            QFile::remove(job->outputFile);
+            if (QFile::copy(cached, job->outputFile)) {
+                {
+                    QMutexLocker locker(&mutex);
+                    job->fromCache = true;
+                    job->opening = false;
+                    job->state = State::Finished;
+                    job->progress = 100;
+                    job->writer.reset();
+                }
+                emit jobChanged(job->id);
+                return;
+            }
+            cache->remove(cacheKey);
+        }
+
+        writer = std::make_shared<OrderedFileWriter>(job->outputFile);
+        writer->setSeparator(kSegmentSeparator);
+        if (!writer->open()) {
+            failJob(job, writer->errorString());
+            return;
+        }
+    }
+
+    QString text;
+    if (!fileHandler.readFile(job->inputFile, text)) {
+        failJob(job, "无法读取文件（文件不存在或编码无法识别）");
+        return;
+    }
+    const qint64 chars = text.length();
+    // 原文放入任务自己的分段存储并计入内存预算；已写入输出文件的分段不再翻译
+    TranslationEngine::DocumentJobPtr document =
+        engine->prepareDocument(std::move(text), job->options, writer);
+
+    bool cancelled = false;
+    {
+        QMutexLocker locker(&mutex);
+        job->opening = false;
+        cancelled = job->removed || job->state == State::Failed;
+        if (!cancelled) {
+            job->fingerprint = fingerprint;
+            if (!cacheKey.isEmpty()) {
+                job->cacheKey = cacheKey;
+            }
+            job->totalChars = chars;
+            job->writer = writer;
+            job->document = document;
+            job->exhausted = false;
+            updateProgress(*job);
+            // 打开期间被暂停
+            if (job->state == State::Paused) {
+                suspendIfIdle(*job);
+            }
+        }
+    }
+
+    if (cancelled) {
+        TranslationEngine::cancelDocument(document);
+        return;
+    }
+    emit jobChanged(job->id);
+}
+
+void JobQueue::runUnit(const JobPtr& job)
+{
+    TranslationEngine::DocumentJobPtr document;
+    {
+        QMutexLocker locker(&mutex);
+        document = job->document;
+    }
+
+    // 分段去重、缓存、后端请求以及写入分段存储和输出文件都在引擎中完成
+    const bool ran = document && engine->runNextDocumentUnit(document);
+    const QString error = document ? TranslationEngine::documentError(document) : QString();
+
+    bool done = false;
+    bool changed = false;
+    {
+        QMutexLocker locker(&mutex);
+        --job->inFlight;
+        if (job->removed || job->state == State::Failed || job->document != document) {
+            return;
+        }
+        if (!ran) {
+            job->exhausted = true;
+        }
+        changed = updateProgress(*job);
+        done = error.isEmpty() && job->exhausted && job->inFlight == 0;
+        if (!done && job->state == State::Paused) {
+            suspendIfIdle(*job);
+        }
+    }
+
+    if (!error.isEmpty()) {
+        failJob(job, error);
+    }
+    else if (done) {
+        finishJob(job);
+    }
+    else if (changed) {
+        emit jobChanged(job->id);
+    }
+}
+
+void JobQueue::suspendIfIdle(Job& job)
+{
+    // 进行中的请求仍在读取原文，全部完成后才释放；输出文件保留到继续或移除
+    if (job.inFlight == 0 && job.document) {
+        job.document.reset();
+        job.exhausted = false;
+    }
+}
+
+bool JobQueue::updateProgress(Job& job)
+{
+    if (!job.writer || job.writer->expectedCount() <= 0) {
+        return false;
+    }
+    const int progress = (job.writer->writtenCount() * 100) / job.writer->expectedCount();
+    const bool changed = progress != job.progress;
+    job.progress = progress;
+    return changed;
+}
+
+void JobQueue::finishJob(const JobPtr& job)
+{
+    std::shared_ptr<OrderedFileWriter> writer;
+    QString cacheKey;
+    {
+        QMutexLocker locker(&mutex);
+        writer = job->writer;
+        cacheKey = job->cacheKey;
+    }
+    if (!writer->commit()) {
+        failJob(job, writer->errorString());
+        return;
+    }
+    cache->store(cacheKey, job->outputFile);
+
+    {
+        QMutexLocker locker(&mutex);
+        job->state = State::Finished;
+        job->progress = 100;
+        // 完成后释放分段存储，只保留界面需要的信息
+        job->document.reset();
+        job->writer.reset();
+    }
+    emit jobChanged(job->id);
+    startWorkers();
+}
+
+void JobQueue::failJob(const JobPtr& job, const QString& error)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (job->state == State::Failed || job->state == State::Finished) {
+            return;
+        }
+        job->state = State::Failed;
+        job->error = error;
+        job->opening = false;
+        if (job->document) {
+            TranslationEngine::cancelDocument(job->document);
+        }
+        // 进行中的请求持有的引用释放后临时文件被删除
+        job->document.reset();
+        job->writer.reset();
+    }
+    emit jobChanged(job->id);
+    startWorkers();
+}
@@ -0,0 +1,98 @@
+﻿#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include "TranslationEngine.h"
+#include "DocumentCache.h"
+
+// 多文档任务队列：文档由引擎规划（分段去重、请求划分、分段存储和内存预算），
+// 请求在引擎的工作线程池中执行，与界面文档共用线程和缓存。
+// 领取顺序：前台任务优先，其次优先级高者，再次剩余字数少者，最后按加入顺序。
+// 暂停只停止领取新请求；进行中的请求完成后释放原文，已完成的分段保留在输出文件中，
+// 继续时重新读取原文并跳过已写入的分段
+class JobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Queued,
+        Running,
+        Paused,
+        Finished,
+        Failed
+    };
+
+    // 任务的只读快照，供界面显示
+    struct JobInfo {
+        int id = 0;
+        QString inputFile;
+        QString outputFile;
+        TranslationOptions options;
+        int priority = 0;
+        State state = State::Queued;
+        int progress = 0;
+        bool foreground = false;
+        bool fromCache = false;
+        QString error;
+    };
+
+    JobQueue(TranslationEngine* engine, DocumentCache* cache, QObject* parent = nullptr);
+    ~JobQueue();
+
+    int addJob(const QString& inputFile, const QString& outputFile,
+        const TranslationOptions& options, int priority = 0);
+    void pauseJob(int id);
+    void resumeJob(int id);
+    void setPriority(int id, int priority);
+    // 同一时间只有一个前台任务；id为0表示取消前台
+    void setForegroundJob(int id);
+    void removeJob(int id);
+
+    QList<JobInfo> jobs() const;
+    JobInfo job(int id) const;
+
+signals:
+    // 可能从工作线程发出
+    void jobChanged(int id);
+    void jobRemoved(int id);
+
+private:
+    struct Job;
+    using JobPtr = std::shared_ptr<Job>;
+
+    void startWorkers();
+    // 调用时须持有mutex
+    void startWorkersLocked();
+    // 每个线程池任务只处理一项工作，完成后把线程交还线程池
+    void runWorker();
+    // 在锁内领取下一项工作：打开任务（open为true）或翻译一个请求
+    bool takeWork(JobPtr& job, bool& open);
+    bool isBetter(const Job& a, const Job& b) const;
+    void openJob(const JobPtr& job);
+    void runUnit(const JobPtr& job);
+    void finishJob(const JobPtr& job);
+    void failJob(const JobPtr& job, const QString& error);
+    // 以下调用时须持有mutex
+    void suspendIfIdle(Job& job);
+    bool updateProgress(Job& job);
+    JobInfo snapshot(const Job& job) const;
+
+    TranslationEngine* engine;
+    DocumentCache* cache;
+
+    mutable QMutex mutex;
+    QWaitCondition idle;
+    QMap<int, JobPtr> jobMap;
+    int nextId;
+    int foregroundId;
+    // 已提交到引擎线程池、尚未结束的任务数
+    int activeWorkers;
+    bool stopping;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,235 @@
+﻿#include "JobQueuePanel.h"
+#include "BatchTranslator.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+
+namespace {
+    QString domainName(Domain domain)
+    {
+        static const QStringList names = { "通用", "医学", "法律", "技术", "学术", "商务" };
+        return names.value(static_cast<int>(domain));
+    }
+}
+
+JobQueuePanel::JobQueuePanel(JobQueue* queue, TranslationEngine* engine, QWidget* parent)
+    : QWidget(parent)
+    , queue(queue)
+    , engine(engine)
+    , outputDirectory(QDir::homePath())
+{
+    table = new QTableWidget(0, ColumnCount, this);
+    table->setHorizontalHeaderLabels({ "文件", "语言", "领域", "优先级", "状态", "进度" });
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setSectionResizeMode(FileColumn, QHeaderView::Stretch);
+
+    addBtn = new QPushButton("添加文件", this);
+    pauseBtn = new QPushButton("暂停", this);
+    raiseBtn = new QPushButton("提高优先级", this);
+    lowerBtn = new QPushButton("降低优先级", this);
+    foregroundBtn = new QPushButton("设为前台", this);
+    removeBtn = new QPushButton("移除", this);
+    foregroundBtn->setToolTip("前台任务优先占用翻译线程，同一时间只有一个");
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(addBtn);
+    buttonLayout->addWidget(pauseBtn);
+    buttonLayout->addWidget(raiseBtn);
+    buttonLayout->addWidget(lowerBtn);
+    buttonLayout->addWidget(foregroundBtn);
+    buttonLayout->addWidget(removeBtn);
+    buttonLayout->addStretch();
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(table);
+
+    connect(addBtn, &QPushButton::clicked, this, &JobQueuePanel::addFiles);
+    connect(pauseBtn, &QPushButton::clicked, this, &JobQueuePanel::togglePause);
+    connect(raiseBtn, &QPushButton::clicked, this, &JobQueuePanel::raisePriority);
+    connect(lowerBtn, &QPushButton::clicked, this, &JobQueuePanel::lowerPriority);
+    connect(foregroundBtn, &QPushButton::clicked, this, &JobQueuePanel::makeForeground);
+    connect(removeBtn, &QPushButton::clicked, this, &JobQueuePanel::removeSelected);
+    connect(table, &QTableWidget::itemSelectionChanged, this, &JobQueuePanel::updateButtons);
+
+    // 信号可能来自工作线程，排队到界面线程处理
+    connect(queue, &JobQueue::jobChanged, this, &JobQueuePanel::onJobChanged, Qt::QueuedConnection);
+    connect(queue, &JobQueue::jobRemoved, this, &JobQueuePanel::onJobRemoved, Qt::QueuedConnection);
+
+    updateButtons();
+}
+
+void JobQueuePanel::addFiles()
+{
+    const QStringList files = QFileDialog::getOpenFileNames(
+        this,
+        "选择要加入队列的文件",
+        QDir::homePath(),
+        "所有支持的文件 (*.txt *.docx *.pdf *.html *.xml *.json);;所有文件 (*.*)"
+    );
+    if (files.isEmpty()) {
+        return;
+    }
+
+    const QString directory = QFileDialog::getExistingDirectory(this, "选择输出目录", outputDirectory);
+    if (directory.isEmpty()) {
+        return;
+    }
+    outputDirectory = directory;
+
+    const TranslationOptions options = engine->currentOptions();
+    for (const QString& file : files) {
+        queue->addJob(file, BatchTranslator::outputPathFor(file, directory, options.targetLang), options);
+    }
+}
+
+int JobQueuePanel::selectedJob() const
+{
+    const int row = table->currentRow();
+    if (row < 0 || !table->selectionModel()->isRowSelected(row, QModelIndex())) {
+        return 0;
+    }
+    return table->item(row, FileColumn)->data(Qt::UserRole).toInt();
+}
+
+void JobQueuePanel::togglePause()
+{
+    const JobQueue::JobInfo info = queue->job(selectedJob());
+    if (info.id == 0) {
+        return;
+    }
+    if (info.state == JobQueue::State::Paused) {
+        queue->resumeJob(info.id);
+    }
+    else {
+        queue->pauseJob(info.id);
+    }
+}
+
+void JobQueuePanel::raisePriority()
+{
+    const JobQueue::JobInfo info = queue->job(selectedJob());
+    if (info.id != 0) {
+        queue->setPriority(info.id, info.priority + 1);
+    }
+}
+
+void JobQueuePanel::lowerPriority()
+{
+    const JobQueue::JobInfo info = queue->job(selectedJob());
+    if (info.id != 0) {
+        queue->setPriority(info.id, info.priority - 1);
+    }
+}
+
+void JobQueuePanel::makeForeground()
+{
+    const JobQueue::JobInfo info = queue->job(selectedJob());
+    if (info.id != 0) {
+        // 再次点击前台任务取消前台
+        queue->setForegroundJob(info.foreground ? 0 : info.id);
+    }
+}
+
+void JobQueuePanel::removeSelected()
+{
+    const int id = selectedJob();
+    if (id != 0) {
+        queue->removeJob(id);
+    }
+}
+
+void JobQueuePanel::onJobChanged(int id)
+{
+    const JobQueue::JobInfo info = queue->job(id);
+    if (info.id == 0) {
+        // 已移除的任务
+        return;
+    }
+
+    auto it = rows.find(id);
+    if (it == rows.end()) {
+        const int row = table->rowCount();
+        table->insertRow(row);
+        for (int column = 0; column < ColumnCount; ++column) {
+            table->setItem(row, column, new QTableWidgetItem());
+        }
+        table->item(row, FileColumn)->setData(Qt::UserRole, id);
+        it = rows.insert(id, row);
+    }
+    updateRow(it.value(), info);
+    updateButtons();
+}
+
+void JobQueuePanel::onJobRemoved(int id)
+{
+    auto it = rows.find(id);
+    if (it == rows.end()) {
+        return;
+    }
+    const int row = it.value();
+    rows.erase(it);
+    table->removeRow(row);
+    for (int& other : rows) {
+        if (other > row) {
+            --other;
+        }
+    }
+    updateButtons();
+}
+
+void JobQueuePanel::updateRow(int row, const JobQueue::JobInfo& info)
+{
+    QTableWidgetItem* fileItem = table->item(row, FileColumn);
+    fileItem->setText(QFileInfo(info.inputFile).fileName());
+    fileItem->setToolTip(info.inputFile + " → " + info.outputFile);
+    QFont font = fileItem->font();
+    font.setBold(info.foreground);
+    fileItem->setFont(font);
+
+    table->item(row, LanguageColumn)->setText(info.options.sourceLang + " → " + info.options.targetLang);
+    table->item(row, DomainColumn)->setText(domainName(info.options.domain));
+    table->item(row, PriorityColumn)->setText(QString::number(info.priority));
+    table->item(row, StateColumn)->setText(stateText(info));
+    table->item(row, StateColumn)->setToolTip(info.error);
+    table->item(row, ProgressColumn)->setText(QString("%1%").arg(info.progress));
+}
+
+QString JobQueuePanel::stateText(const JobQueue::JobInfo& info)
+{
+    switch (info.state) {
+    case JobQueue::State::Queued:
+        return info.foreground ? "排队中（前台）" : "排队中";
+    case JobQueue::State::Running:
+        return info.foreground ? "翻译中（前台）" : "翻译中";
+    case JobQueue::State::Paused:
+        return "已暂停";
+    case JobQueue::State::Finished:
+        return info.fromCache ? "已完成（缓存）" : "已完成";
+    case JobQueue::State::Failed:
+        return "失败";
+    }
+    return QString();
+}
+
+void JobQueuePanel::updateButtons()
+{
+    const JobQueue::JobInfo info = queue->job(selectedJob());
+    const bool active = info.id != 0
+        && info.state != JobQueue::State::Finished && info.state != JobQueue::State::Failed;
+
+    pauseBtn->setText(info.state == JobQueue::State::Paused ? "继续" : "暂停");
+    pauseBtn->setEnabled(active);
+    raiseBtn->setEnabled(active);
+    lowerBtn->setEnabled(active);
+    foregroundBtn->setText(info.foreground ? "取消前台" : "设为前台");
+    foregroundBtn->setEnabled(active);
+    removeBtn->setEnabled(info.id != 0);
+}
@@ -0,0 +1,59 @@
+﻿#ifndef JOBQUEUEPANEL_H
+#define JOBQUEUEPANEL_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QMap>
+#include "JobQueue.h"
+
+// 任务队列面板：每行一个文档任务，可暂停/继续、调整优先级、设为前台或移除。
+// 新任务使用加入时引擎的语言和领域设置，之后修改主界面设置不影响已加入的任务
+class JobQueuePanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    JobQueuePanel(JobQueue* queue, TranslationEngine* engine, QWidget* parent = nullptr);
+
+private slots:
+    void addFiles();
+    void togglePause();
+    void raisePriority();
+    void lowerPriority();
+    void makeForeground();
+    void removeSelected();
+    void onJobChanged(int id);
+    void onJobRemoved(int id);
+    void updateButtons();
+
+private:
+    enum Column {
+        FileColumn = 0,
+        LanguageColumn,
+        DomainColumn,
+        PriorityColumn,
+        StateColumn,
+        ProgressColumn,
+        ColumnCount
+    };
+
+    int selectedJob() const;
+    void updateRow(int row, const JobQueue::JobInfo& info);
+    static QString stateText(const JobQueue::JobInfo& info);
+
+    JobQueue* queue;
+    TranslationEngine* engine;
+    QTableWidget* table;
+    QPushButton* addBtn;
+    QPushButton* pauseBtn;
+    QPushButton* raiseBtn;
+    QPushButton* lowerBtn;
+    QPushButton* foregroundBtn;
+    QPushButton* removeBtn;
+    // 任务id到表格行
+    QMap<int, int> rows;
+    QString outputDirectory;
+};
+
+#endif
@@ -0,0 +1,260 @@
+﻿#include "LoadTest.h"
+#include "TranslationEngine.h"
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 段落长度范围：任意两段之和都超过文档分段上限，保证每个分段恰好是一个段落
+    const int kMinParagraphChars = 260;
+    const int kMaxParagraphChars = 480;
+    // 每隔若干词插入一个子句分隔符；段落内部不出现句号，只在段尾出现
+    const int kMinClauseWords = 6;
+    const int kMaxClauseWords = 14;
+
+    const QStringList kColumns = {
+        "chars", "conc", "segments", "calls", "dispatched", "coalesced", "wall_ms",
+        "seg/s", "chars/s", "p50_ms", "p95_ms", "p99_ms", "max_ms", "failures", "throttled"
+    };
+
+    enum class Script {
+        Latin,
+        Cjk,
+        Cyrillic
+    };
+
+    int uniform(std::mt19937& random, int low, int high)
+    {
+        return std::uniform_int_distribution<int>(low, high)(random);
+    }
+
+    void appendWord(QString& text, std::mt19937& random, Script script)
+    {
+        switch (script) {
+        case Script::Latin:
+            for (int i = uniform(random, 2, 9); i > 0; --i) {
+                text += QChar(uniform(random, 'a', 'z'));
+            }
+            break;
+        case Script::Cjk:
+            for (int i = uniform(random, 1, 3); i > 0; --i) {
+                text += QChar(uniform(random, 0x4E00, 0x9FA5));
+            }
+            break;
+        case Script::Cyrillic:
+            for (int i = uniform(random, 2, 9); i > 0; --i) {
+                text += QChar(uniform(random, 0x0430, 0x044F));
+            }
+            break;
+        }
+    }
+
+    // 最近秩法，samples必须已排序
+    double percentile(const QVector<double>& samples, double p)
+    {
+        if (samples.isEmpty()) {
+            return 0.0;
+        }
+        const qsizetype rank = static_cast<qsizetype>(std::ceil(p * samples.size()));
+        return samples.at(std::clamp<qsizetype>(rank - 1, 0, samples.size() - 1));
+    }
+
+    QStringList resultFields(const LoadTestResult& result)
+    {
+        return {
+            QString::number(result.chars),
+            QString::number(result.concurrency),
+            QString::number(result.segments),
+            QString::number(result.backendCalls),
+            QString::number(result.dispatchedSegments),
+            QString::number(result.coalescedSegments),
+            QString::number(result.wallMs, 'f', 0),
+            QString::number(result.segmentsPerSecond, 'f', 1),
+            QString::number(result.charsPerSecond, 'f', 0),
+            QString::number(result.p50Ms, 'f', 1),
+            QString::number(result.p95Ms, 'f', 1),
+            QString::number(result.p99Ms, 'f', 1),
+            QString::number(result.maxMs, 'f', 1),
+            QString::number(result.failures),
+            QString::number(result.throttled)
+        };
+    }
+}
+
+QString CorpusGenerator::generate(const CorpusSpec& spec)
+{
+    std::mt19937 random(spec.seed);
+
+    std::vector<double> weights = {
+        std::max(spec.latinWeight, 0.0),
+        std::max(spec.cjkWeight, 0.0),
+        std::max(spec.cyrillicWeight, 0.0)
+    };
+    if (weights[0] + weights[1] + weights[2] <= 0.0) {
+        weights[0] = 1.0;
+    }
+    std::discrete_distribution<int> pickScript(weights.begin(), weights.end());
+    std::bernoulli_distribution pickRepeat(std::clamp(spec.repetitionRatio, 0.0, 1.0));
+
+    QString document;
+    document.reserve(spec.chars + kMaxParagraphChars + 16);
+    QStringList paragraphs;
+
+    while (document.length() < spec.chars) {
+        if (!paragraphs.isEmpty() && pickRepeat(random)) {
+            document += paragraphs.at(uniform(random, 0, paragraphs.size() - 1));
+            continue;
+        }
+
+        // 段首换行、段尾句号，重复的段落切分后得到完全相同的分段
+        QString paragraph = "\n";
+        const int targetLength = uniform(random, kMinParagraphChars, kMaxParagraphChars);
+        int clauseWords = uniform(random, kMinClauseWords, kMaxClauseWords);
+        Script previous = Script::Latin;
+        bool first = true;
+        while (paragraph.length() < targetLength) {
+            const Script script = static_cast<Script>(pickScript(random));
+            if (!first && !(script == Script::Cjk && previous == Script::Cjk)) {
+                paragraph += ' ';
+            }
+            appendWord(paragraph, random, script);
+            previous = script;
+            first = false;
+
+            if (--clauseWords == 0) {
+                paragraph += ',';
+                clauseWords = uniform(random, kMinClauseWords, kMaxClauseWords);
+            }
+        }
+        paragraph += '.';
+
+        paragraphs << paragraph;
+        document += paragraph;
+    }
+
+    return document;
+}
+
+LoadTestHarness::LoadTestHarness(const LoadTestConfig& config)
+    : config(config)
+{
+}
+
+QVector<LoadTestResult> LoadTestHarness::run()
+{
+    QVector<LoadTestResult> results;
+    for (qsizetype chars : config.documentSizes) {
+        CorpusSpec spec = config.corpus;
+        spec.chars = chars;
+        const QString document = CorpusGenerator::generate(spec);
+
+        for (int concurrency : config.concurrencyLevels) {
+            results.append(runOne(document, concurrency));
+        }
+    }
+    return results;
+}
+
+LoadTestResult LoadTestHarness::runOne(const QString& document, int concurrency)
+{
+    LoadTestResult result;
+    result.chars = document.length();
+    result.concurrency = concurrency;
+
+    auto backend = std::make_shared<MockBackend>(config.backend);
+    {
+        TranslationEngine engine;
+        engine.setBackend(backend);
+        engine.setMaxConcurrency(concurrency);
+        engine.loadDocument(document);
+        result.segments = engine.segmentStore()->count();
+
+        QEventLoop loop;
+        bool done = false;
+        QObject::connect(&engine, &TranslationEngine::documentTranslationFinished, &loop, [&]() {
+            done = true;
+            loop.quit();
+        });
+        QObject::connect(&engine, &TranslationEngine::errorOccurred, &loop, [&](const QString& error) {
+            if (result.error.isEmpty()) {
+                result.error = error;
+            }
+            done = true;
+            loop.quit();
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        engine.translateDocument();
+        if (!done) {
+            loop.exec();
+        }
+        result.wallMs = timer.nsecsElapsed() / 1.0e6;
+
+        // 出错时停止剩余请求；引擎析构时等待工作线程退出
+        engine.cancelTranslation();
+        result.dispatchedSegments = engine.dispatchedSegmentCount();
+        result.coalescedSegments = engine.coalescedSegmentCount();
+    }
+
+    const MockBackend::Stats stats = backend->stats();
+    result.backendCalls = stats.calls;
+    result.failures = stats.failures;
+    result.throttled = stats.throttled;
+
+    if (result.wallMs > 0.0) {
+        result.segmentsPerSecond = result.segments * 1000.0 / result.wallMs;
+        result.charsPerSecond = result.chars * 1000.0 / result.wallMs;
+    }
+
+    QVector<double> latencies = backend->takeLatencySamples();
+    std::sort(latencies.begin(), latencies.end());
+    result.p50Ms = percentile(latencies, 0.50);
+    result.p95Ms = percentile(latencies, 0.95);
+    result.p99Ms = percentile(latencies, 0.99);
+    result.maxMs = latencies.isEmpty() ? 0.0 : latencies.last();
+    return result;
+}
+
+QString LoadTestHarness::formatReport(const QVector<LoadTestResult>& results)
+{
+    QVector<QStringList> rows;
+    rows.append(kColumns);
+    for (const LoadTestResult& result : results) {
+        rows.append(resultFields(result));
+    }
+
+    // 按列对齐
+    QVector<qsizetype> widths(kColumns.size(), 0);
+    for (const QStringList& row : rows) {
+        for (int column = 0; column < row.size(); ++column) {
+            widths[column] = std::max(widths.at(column), row.at(column).length());
+        }
+    }
+
+    QString report;
+    for (int i = 0; i < rows.size(); ++i) {
+        const QStringList& row = rows.at(i);
+        for (int column = 0; column < row.size(); ++column) {
+            report += row.at(column).rightJustified(widths.at(column) + 2);
+        }
+        if (i > 0 && !results.at(i - 1).error.isEmpty()) {
+            report += "  未完成: " + results.at(i - 1).error;
+        }
+        report += '\n';
+    }
+    return report;
+}
+
+QString LoadTestHarness::formatCsv(const QVector<LoadTestResult>& results)
+{
+    QString csv = kColumns.join(',') + ",error\n";
+    for (const LoadTestResult& result : results) {
+        QString error = result.error;
+        error.replace('"', "\"\"");
+        csv += resultFields(result).join(',') + ",\"" + error + "\"\n";
+    }
+    return csv;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+﻿#ifndef LOADTEST_H
+#define LOADTEST_H
+
+#include <QString>
+#include <QVector>
+#include "TranslationBackend.h"
+
+// 合成语料的参数
+struct CorpusSpec {
+    qsizetype chars = 100000;
+    // 与前文某一段完全相同的段落比例
+    double repetitionRatio = 0.2;
+    // 各文字的词数占比，按比例归一化
+    double latinWeight = 1.0;
+    double cjkWeight = 0.0;
+    double cyrillicWeight = 0.0;
+    quint32 seed = 1;
+};
+
+// 生成用于压测的文档：段落长度落在一个文档分段之内，重复段落会被引擎去重
+class CorpusGenerator
+{
+public:
+    static QString generate(const CorpusSpec& spec);
+};
+
+struct LoadTestConfig {
+    MockBackend::Config backend;
+    CorpusSpec corpus;
+    QVector<qsizetype> documentSizes;
+    QVector<int> concurrencyLevels;
+};
+
+// 一次（文档大小，并发数）组合的测量结果
+struct LoadTestResult {
+    qsizetype chars = 0;
+    int concurrency = 0;
+    int segments = 0;
+    quint64 backendCalls = 0;
+    quint64 dispatchedSegments = 0;
+    quint64 coalescedSegments = 0;
+    quint64 failures = 0;
+    quint64 throttled = 0;
+    double wallMs = 0.0;
+    double segmentsPerSecond = 0.0;
+    double charsPerSecond = 0.0;
+    // 单次后端调用耗时（毫秒，含限流等待）
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    QString error;
+};
+
+// 压测：对每种文档大小和并发数用独立的引擎和模拟后端完整翻译一次文档
+class LoadTestHarness
+{
+public:
+    explicit LoadTestHarness(const LoadTestConfig& config);
+
+    QVector<LoadTestResult> run();
+
+    static QString formatReport(const QVector<LoadTestResult>& results);
+    static QString formatCsv(const QVector<LoadTestResult>& results);
+
+private:
+    LoadTestResult runOne(const QString& document, int concurrency);
+
+    LoadTestConfig config;
+};
+
+#endif
\ No newline at end of file
@@ -7,15 +7,54 @@
 #include <QGroupBox>
 #include <QLineEdit>
 #include <QTextDocument>
+#include <QHeaderView>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QListWidget>
+#include <QScrollBar>
+#include <QCheckBox>
+#include "MemoryBudget.h"
+#include "StartupTrace.h"
+
+namespace {
+    // 界面语言名称到引擎语言代码的映射
+    QString languageCode(const QString& name)
+    {
+        static const QMap<QString, QString> codes = {
+            {"自动检测", "auto"}, {"英语", "en"}, {"中文", "zh"}, {"日语", "ja"},
+            {"韩语", "ko"}, {"法语", "fr"}, {"德语", "de"}, {"西班牙语", "es"}, {"俄语", "ru"}
+        };
+        return codes.value(name, name);
+    }
+
+    const char* const kWarmingUpStatus = "正在加载术语词典和翻译后端...";
+}
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , translationEngine(new TranslationEngine(this))
     , fileHandler(new FileHandler(this))
+    , documentCache(std::make_unique<DocumentCache>())
+    , jobQueue(new JobQueue(translationEngine, documentCache.get(), this))
 {
-    setupUI();
-    setupConnections();
-    loadSettings();
+    // 术语词典和翻译后端在后台预热，与构建界面同时进行
+    connect(translationEngine, &TranslationEngine::ready,
+        this, &MainWindow::onEngineReady, Qt::QueuedConnection);
+    translationEngine->warmUp();
+
+    {
+        StartupTrace::Scope scope("构建界面");
+        setupUI();
+    }
+    {
+        StartupTrace::Scope scope("连接信号");
+        setupConnections();
+    }
+    {
+        StartupTrace::Scope scope("读取设置");
+        loadSettings();
+    }
+    statusLabel->setText(kWarmingUpStatus);
 
     setWindowTitle("专业文档翻译工具 v1.0");
     setMinimumSize(1200, 800);
@@ -37,6 +76,7 @@ void MainWindow::setupUI()
     openFileBtn = new QPushButton("打开文件", this);
     saveFileBtn = new QPushButton("保存翻译", this);
     translateBtn = new QPushButton("开始翻译", this);
+    multiLangBtn = new QPushButton("多语言翻译", this);
 
     sourceLangCombo = new QComboBox(this);
     targetLangCombo = new QComboBox(this);
@@ -67,6 +107,10 @@ void MainWindow::setupUI()
     apiKeyEdit->setPlaceholderText("输入翻译API密钥");
     apiKeyEdit->setEchoMode(QLineEdit::Password);
 
+    // 打开文件后利用用户查看设置的时间提前翻译
+    speculativeCheck = new QCheckBox("预翻译", this);
+    speculativeCheck->setToolTip("打开文件后按当前语言和领域在后台提前翻译，开始翻译时直接使用已完成的结果");
+
     controlLayout->addWidget(new QLabel("源语言:"));
     controlLayout->addWidget(sourceLangCombo);
     controlLayout->addWidget(new QLabel("目标语言:"));
@@ -76,13 +120,16 @@ void MainWindow::setupUI()
     controlLayout->addWidget(new QLabel("格式:"));
     controlLayout->addWidget(fileFormatCombo);
     controlLayout->addWidget(apiKeyEdit);
+    controlLayout->addWidget(speculativeCheck);
     controlLayout->addWidget(openFileBtn);
     controlLayout->addWidget(translateBtn);
+    controlLayout->addWidget(multiLangBtn);
     controlLayout->addWidget(saveFileBtn);
     controlLayout->addStretch();
 
     // 文本编辑区域
-    QHBoxLayout* textLayout = new QHBoxLayout();
+    QWidget* textPage = new QWidget(this);
+    QHBoxLayout* textLayout = new QHBoxLayout(textPage);
 
     QGroupBox* sourceGroup = new QGroupBox("原文", this);
     QGroupBox* targetGroup = new QGroupBox("译文", this);
@@ -106,6 +153,27 @@ void MainWindow::setupUI()
     textLayout->addWidget(sourceGroup);
     textLayout->addWidget(targetGroup);
 
+    // 分段对照视图：原文与译文同一行对齐，只绘制可见行
+    segmentModel = new SegmentTableModel(translationEngine->segmentStore(), this);
+    segmentView = new QTableView(this);
+    segmentView->setModel(segmentModel);
+    segmentView->setWordWrap(false);
+    segmentView->setTextElideMode(Qt::ElideRight);
+    segmentView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    segmentView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    segmentView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    segmentView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    segmentView->verticalHeader()->setDefaultSectionSize(segmentView->fontMetrics().height() + 8);
+    segmentView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+    viewTabs = new QTabWidget(this);
+    viewTabs->addTab(textPage, "文本");
+    viewTabs->addTab(segmentView, "分段对照");
+
+    // 多文档任务队列，与当前文档共用翻译引擎和缓存
+    jobQueuePanel = new JobQueuePanel(jobQueue, translationEngine, this);
+    viewTabs->addTab(jobQueuePanel, "任务队列");
+
     // 进度条
     progressBar = new QProgressBar(this);
     progressBar->setVisible(false);
@@ -114,7 +182,7 @@ void MainWindow::setupUI()
     statusLabel = new QLabel("就绪", this);
 
     mainLayout->addLayout(controlLayout);
-    mainLayout->addLayout(textLayout);
+    mainLayout->addWidget(viewTabs);
     mainLayout->addWidget(progressBar);
     mainLayout->addWidget(statusLabel);
 
@@ -130,13 +198,27 @@ void MainWindow::setupConnections()
     connect(openFileBtn, &QPushButton::clicked, this, &MainWindow::openSourceFile);
     connect(saveFileBtn, &QPushButton::clicked, this, &MainWindow::saveTranslatedFile);
     connect(translateBtn, &QPushButton::clicked, this, &MainWindow::startTranslation);
+    connect(multiLangBtn, &QPushButton::clicked, this, &MainWindow::startMultiLanguageTranslation);
 
     connect(translationEngine, &TranslationEngine::translationProgress,
         this, &MainWindow::translationProgress);
     connect(translationEngine, &TranslationEngine::translationFinished,
         this, &MainWindow::translationFinished);
+    connect(translationEngine, &TranslationEngine::documentTranslationFinished,
+        this, &MainWindow::documentTranslationFinished);
     connect(translationEngine, &TranslationEngine::errorOccurred,
         this, &MainWindow::translationError);
+
+    // 可见分段变化时通知引擎优先翻译这一部分
+    connect(segmentView->verticalScrollBar(), &QScrollBar::valueChanged,
+        this, &MainWindow::updateVisibleSegments);
+    connect(segmentView->verticalScrollBar(), &QScrollBar::rangeChanged,
+        this, &MainWindow::updateVisibleSegments);
+    connect(viewTabs, &QTabWidget::currentChanged, this, &MainWindow::updateVisibleSegments);
+
+    connect(sourceLangCombo, &QComboBox::currentTextChanged, this, &MainWindow::onLanguageChanged);
+    connect(targetLangCombo, &QComboBox::currentTextChanged, this, &MainWindow::onLanguageChanged);
+    connect(speculativeCheck, &QCheckBox::toggled, this, &MainWindow::restartSpeculativeTranslation);
 }
 
 void MainWindow::openSourceFile()
@@ -154,20 +236,36 @@ void MainWindow::openSourceFile()
         QString content;
 
         if (fileHandler->readFile(filePath, content)) {
-            sourceTextEdit->setPlainText(content);
-            statusLabel->setText(QString("已加载文件: %1").arg(QFileInfo(filePath).fileName()));
+            // 文件内容只进入分段存储，不再整体放入文本框
+            translationEngine->loadDocument(std::move(content));
+            viewTabs->setCurrentWidget(segmentView);
+            statusLabel->setText(QString("已加载文件: %1 (%2, %3 个分段)")
+                .arg(QFileInfo(filePath).fileName())
+                .arg(fileHandler->detectedEncoding().isEmpty() ? "-" : fileHandler->detectedEncoding())
+                .arg(translationEngine->segmentStore()->count()));
+            restartSpeculativeTranslation();
         }
         else {
-            QMessageBox::warning(this, "错误", "无法读取文件: " + filePath);
+            QMessageBox::warning(this, "错误", "无法读取文件（文件不存在或编码无法识别）: " + filePath);
         }
     }
 }
 
 void MainWindow::saveTranslatedFile()
 {
-    QString translatedText = translatedTextEdit->toPlainText();
-    if (translatedText.isEmpty()) {
-        QMessageBox::information(this, "提示", "没有可保存的翻译内容");
+    const bool documentMode = isDocumentMode();
+    QString translatedText;
+    if (!documentMode) {
+        translatedText = translatedTextEdit->toPlainText();
+    }
+
+    // 文档模式逐段检查：译文缺失或已随输出文件释放时不保存
+    QString error;
+    bool hasContent = documentMode
+        ? translationEngine->canWriteDocument(&error)
+        : !translatedText.isEmpty();
+    if (!hasContent) {
+        QMessageBox::information(this, "提示", error.isEmpty() ? QString("没有可保存的翻译内容") : error);
         return;
     }
 
@@ -180,17 +278,38 @@ void MainWindow::saveTranslatedFile()
     );
 
     if (!filePath.isEmpty()) {
-        if (fileHandler->writeFile(filePath, translatedText)) {
+        // 文档模式直接从分段存储流式写出，不拼接整篇译文
+        bool saved = documentMode
+            ? translationEngine->writeDocument(filePath, &error)
+            : fileHandler->writeFile(filePath, translatedText);
+        if (saved) {
             statusLabel->setText(QString("已保存到: %1").arg(QFileInfo(filePath).fileName()));
         }
         else {
-            QMessageBox::warning(this, "错误", "保存文件失败: " + filePath);
+            QMessageBox::warning(this, "错误", "保存文件失败: " + filePath
+                + (error.isEmpty() ? QString() : "\n" + error));
         }
     }
 }
 
 void MainWindow::startTranslation()
 {
+    if (isDocumentMode()) {
+        if (translationEngine->segmentStore()->count() == 0) {
+            QMessageBox::information(this, "提示", "请先打开要翻译的文件");
+            return;
+        }
+
+        progressBar->setVisible(true);
+        progressBar->setValue(0);
+        translateBtn->setEnabled(false);
+        multiLangBtn->setEnabled(false);
+
+        statusLabel->setText("正在翻译...");
+        translationEngine->translateDocument();
+        return;
+    }
+
     QString sourceText = sourceTextEdit->toPlainText().trimmed();
     if (sourceText.isEmpty()) {
         QMessageBox::information(this, "提示", "请输入要翻译的文本或打开文件");
@@ -211,6 +330,72 @@ void MainWindow::startTranslation()
     translationEngine->translateText(sourceText);
 }
 
+void MainWindow::startMultiLanguageTranslation()
+{
+    if (translationEngine->segmentStore()->count() == 0) {
+        QMessageBox::information(this, "提示", "请先打开要翻译的文件");
+        return;
+    }
+
+    // 选择目标语言
+    QDialog dialog(this);
+    dialog.setWindowTitle("选择目标语言");
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+    QListWidget* languageList = new QListWidget(&dialog);
+    for (int i = 0; i < targetLangCombo->count(); ++i) {
+        QString name = targetLangCombo->itemText(i);
+        if (languageCode(name) == "auto") {
+            continue;
+        }
+        QListWidgetItem* item = new QListWidgetItem(name, languageList);
+        item->setCheckState(name == targetLangCombo->currentText() ? Qt::Checked : Qt::Unchecked);
+    }
+    QDialogButtonBox* buttons = new QDialogButtonBox(
+        QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(languageList);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QStringList languages;
+    for (int i = 0; i < languageList->count(); ++i) {
+        if (languageList->item(i)->checkState() == Qt::Checked) {
+            languages << languageCode(languageList->item(i)->text());
+        }
+    }
+    if (languages.isEmpty()) {
+        return;
+    }
+
+    QString outputDir = QFileDialog::getExistingDirectory(this, "选择输出目录", QDir::homePath());
+    if (outputDir.isEmpty()) {
+        return;
+    }
+
+    // 每种语言一个输出文件，翻译过程中按顺序写出
+    QString baseName = QFileInfo(currentSourceFile).baseName();
+    if (baseName.isEmpty()) {
+        baseName = "translated";
+    }
+    QStringList outputPaths;
+    for (const QString& language : languages) {
+        outputPaths << QDir(outputDir).filePath(QString("%1_%2.txt").arg(baseName, language));
+    }
+
+    viewTabs->setCurrentWidget(segmentView);
+    progressBar->setVisible(true);
+    progressBar->setValue(0);
+    translateBtn->setEnabled(false);
+    multiLangBtn->setEnabled(false);
+
+    statusLabel->setText(QString("正在翻译为 %1 种语言...").arg(languages.size()));
+    translationEngine->translateDocuments(languages, outputPaths);
+}
+
 void MainWindow::translationProgress(int value)
 {
     progressBar->setValue(value);
@@ -225,11 +410,23 @@ void MainWindow::translationFinished(const QString& translatedText)
     statusLabel->setText("翻译完成");
 }
 
+void MainWindow::documentTranslationFinished()
+{
+    progressBar->setVisible(false);
+    translateBtn->setEnabled(true);
+    multiLangBtn->setEnabled(true);
+    statusLabel->setText(QString("翻译完成（累计发送 %1 个分段，合并重复请求 %2 个，使用缓存 %3 个）")
+        .arg(translationEngine->dispatchedSegmentCount())
+        .arg(translationEngine->coalescedSegmentCount())
+        .arg(translationEngine->cachedSegmentCount()));
+}
+
 void MainWindow::translationError(const QString& error)
 {
     QMessageBox::critical(this, "翻译错误", "翻译过程中发生错误:\n" + error);
     progressBar->setVisible(false);
     translateBtn->setEnabled(true);
+    multiLangBtn->setEnabled(true);
     statusLabel->setText("翻译失败: " + error);
 }
 
@@ -242,6 +439,11 @@ void MainWindow::loadSettings()
     sourceLangCombo->setCurrentText(settings.value("sourceLang", "英语").toString());
     targetLangCombo->setCurrentText(settings.value("targetLang", "中文").toString());
     domainCombo->setCurrentIndex(settings.value("domain", 0).toInt());
+    speculativeCheck->setChecked(settings.value("speculative_translation", true).toBool());
+
+    // 所有文档共用的内存预算（MB）
+    qint64 budgetMb = settings.value("memory_budget_mb", 512).toLongLong();
+    MemoryBudget::instance().setLimit(budgetMb * 1024 * 1024);
 }
 
 void MainWindow::saveSettings()
@@ -252,6 +454,22 @@ void MainWindow::saveSettings()
     settings.setValue("sourceLang", sourceLangCombo->currentText());
     settings.setValue("targetLang", targetLangCombo->currentText());
     settings.setValue("domain", domainCombo->currentIndex());
+    settings.setValue("speculative_translation", speculativeCheck->isChecked());
+    settings.setValue("memory_budget_mb", MemoryBudget::instance().limit() / (1024 * 1024));
+}
+
+bool MainWindow::isDocumentMode() const
+{
+    return viewTabs->currentWidget() == segmentView;
+}
+
+void MainWindow::onEngineReady()
+{
+    // 用户已开始操作时不覆盖其状态信息
+    if (statusLabel->text() == kWarmingUpStatus) {
+        statusLabel->setText("就绪");
+    }
+    StartupTrace::instance().markReady();
 }
 
 void MainWindow::onApiKeyChanged(const QString& key)
@@ -266,7 +484,41 @@ void MainWindow::onDomainChanged(int index)
     if (translationEngine) {
         Domain domain = static_cast<Domain>(index);
         translationEngine->setDomain(domain);
+        restartSpeculativeTranslation();
+    }
+}
+
+void MainWindow::onLanguageChanged()
+{
+    translationEngine->setSourceLanguage(languageCode(sourceLangCombo->currentText()));
+    translationEngine->setTargetLanguage(languageCode(targetLangCombo->currentText()));
+    restartSpeculativeTranslation();
+}
+
+void MainWindow::restartSpeculativeTranslation()
+{
+    // 正式翻译进行中不预翻译；按旧设置完成的结果仍留在缓存中
+    if (!speculativeCheck->isChecked() || !translateBtn->isEnabled()
+        || translationEngine->segmentStore()->count() == 0) {
+        translationEngine->cancelSpeculativeTranslation();
+        return;
+    }
+    translationEngine->startSpeculativeTranslation();
+}
+
+void MainWindow::updateVisibleSegments()
+{
+    const int first = isDocumentMode() ? segmentView->rowAt(0) : -1;
+    if (first < 0) {
+        translationEngine->setPriorityRange(-1, -1);
+        return;
+    }
+
+    int last = segmentView->rowAt(segmentView->viewport()->height() - 1);
+    if (last < 0) {
+        last = segmentModel->rowCount() - 1;
     }
+    translationEngine->setPriorityRange(first, last);
 }
 
 void MainWindow::updateCharacterCount()
@@ -282,4 +534,6 @@ void MainWindow::updateCharacterCount()
 MainWindow::~MainWindow()
 {
     saveSettings();
+    // 任务队列的工作线程仍在使用引擎和文档缓存，先于它们销毁
+    delete jobQueue;
 }
\ No newline at end of file
@@ -9,8 +9,16 @@
 #include <QFileDialog>
 #include <QSettings>
 #include <QLabel>
+#include <QTabWidget>
+#include <QTableView>
+#include <QCheckBox>
 #include "TranslationEngine.h"
 #include "FileHandler.h"
+#include "SegmentTableModel.h"
+#include "DocumentCache.h"
+#include "JobQueue.h"
+#include "JobQueuePanel.h"
+#include <memory>
 
 class MainWindow : public QMainWindow
 {
@@ -24,22 +32,32 @@ private slots:
     void openSourceFile();
     void saveTranslatedFile();
     void startTranslation();
+    void startMultiLanguageTranslation();
     void translationProgress(int value);
     void translationFinished(const QString& translatedText);
+    void documentTranslationFinished();
     void translationError(const QString& error);
     void onApiKeyChanged(const QString& key);
     void onDomainChanged(int index);
+    void onLanguageChanged();
+    void restartSpeculativeTranslation();
     void updateCharacterCount();
+    void updateVisibleSegments();
+    void onEngineReady();
 
 private:
     void setupUI();
     void setupConnections();
     void loadSettings();
     void saveSettings();
+    bool isDocumentMode() const;
 
     // UI Components
     QTextEdit* sourceTextEdit;
     QTextEdit* translatedTextEdit;
+    QTabWidget* viewTabs;
+    QTableView* segmentView;
+    SegmentTableModel* segmentModel;
     QComboBox* sourceLangCombo;
     QComboBox* targetLangCombo;
     QComboBox* fileFormatCombo;
@@ -47,6 +65,8 @@ private:
     QPushButton* openFileBtn;
     QPushButton* saveFileBtn;
     QPushButton* translateBtn;
+    QPushButton* multiLangBtn;
+    QCheckBox* speculativeCheck;
     QProgressBar* progressBar;
     QLabel* charCountLabel;
     QLabel* statusLabel;
@@ -54,6 +74,9 @@ private:
     // Core components
     TranslationEngine* translationEngine;
     FileHandler* fileHandler;
+    std::unique_ptr<DocumentCache> documentCache;
+    JobQueue* jobQueue;
+    JobQueuePanel* jobQueuePanel;
 
     QString currentSourceFile;
     QString currentTargetFile;
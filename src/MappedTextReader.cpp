@@ -0,0 +1,419 @@
+﻿#include "MappedTextReader.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TRANSLATIONTOOL_HAVE_SSE2
+#endif
+
+namespace {
+    // 编码识别的采样大小
+    const qsizetype kSampleBytes = 64 * 1024;
+    // 双字节编码中常用字区的字符至少占这个比例才接受
+    const double kMinCommonRatio = 0.6;
+
+    // 采样末尾可能截断一个多字节字符，退回到完整字符的边界
+    qsizetype utf8SampleBoundary(const unsigned char* data, qsizetype length)
+    {
+        qsizetype end = length;
+        qsizetype back = 0;
+        while (end > 0 && back < 3 && (data[end - 1] & 0xC0) == 0x80) {
+            --end;
+            ++back;
+        }
+        if (end > 0 && data[end - 1] >= 0xC0) {
+            --end;
+        }
+        else if (back > 0) {
+            end += back;
+        }
+        return end;
+    }
+
+    // 按GB18030或Big5的字节结构扫描采样，返回常用字区字符所占的比例；
+    // 出现该编码不允许的字节组合时返回-1。
+    // GB18030常用字区为GB2312（首尾字节都在0xA1以上），Big5为0xA1-0xF9首字节
+    double doubleByteScore(const unsigned char* bytes, qsizetype length, bool big5)
+    {
+        qsizetype chars = 0;
+        qsizetype common = 0;
+        qsizetype i = 0;
+        while (i < length) {
+            const unsigned char lead = bytes[i];
+            if (lead < 0x80) {
+                ++i;
+                continue;
+            }
+            if (lead == 0x80 || lead == 0xFF) {
+                return -1;
+            }
+            if (i + 1 >= length) {
+                // 采样末尾截断的字符
+                break;
+            }
+            const unsigned char trail = bytes[i + 1];
+            if (!big5 && trail >= 0x30 && trail <= 0x39) {
+                // GB18030四字节字符
+                if (i + 3 >= length) {
+                    break;
+                }
+                if (bytes[i + 2] < 0x81 || bytes[i + 2] == 0xFF
+                    || bytes[i + 3] < 0x30 || bytes[i + 3] > 0x39) {
+                    return -1;
+                }
+                ++chars;
+                i += 4;
+                continue;
+            }
+
+            const bool lowTrail = trail >= 0x40 && trail <= 0x7E;
+            const bool highTrail = big5 ? (trail >= 0xA1 && trail <= 0xFE)
+                : (trail >= 0x80 && trail <= 0xFE);
+            if (!lowTrail && !highTrail) {
+                return -1;
+            }
+            ++chars;
+            if (big5) {
+                common += lead >= 0xA1 && lead <= 0xF9;
+            }
+            else {
+                common += lead >= 0xA1 && lead <= 0xF7 && trail >= 0xA1;
+            }
+            i += 2;
+        }
+        return chars > 0 ? double(common) / chars : -1;
+    }
+
+    // 跳过连续的ASCII字节，返回第一个非ASCII字节的位置
+    const unsigned char* skipAscii(const unsigned char* p, const unsigned char* end)
+    {
+#ifdef TRANSLATIONTOOL_HAVE_SSE2
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            if (_mm_movemask_epi8(chunk) != 0) {
+                break;
+            }
+            p += 16;
+        }
+#endif
+        while (end - p >= 8) {
+            quint64 word;
+            std::memcpy(&word, p, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                break;
+            }
+            p += 8;
+        }
+        while (p < end && *p < 0x80) {
+            ++p;
+        }
+        return p;
+    }
+}
+
+MappedTextReader::MappedTextReader(const QString& filePath)
+    : file(filePath)
+    , data(nullptr)
+    , length(0)
+    , detected(Encoding::Unknown)
+    , bomLength(0)
+    , decodedSize(0)
+{
+}
+
+MappedTextReader::~MappedTextReader()
+{
+    close();
+}
+
+bool MappedTextReader::open()
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    length = file.size();
+    if (length > 0) {
+        uchar* mapped = file.map(0, length);
+        if (mapped) {
+            data = reinterpret_cast<const char*>(mapped);
+        }
+        else {
+            // 无法映射（如管道、特殊文件系统）时退回到整体读取
+            fallbackBuffer = file.readAll();
+            data = fallbackBuffer.constData();
+            length = fallbackBuffer.size();
+        }
+    }
+
+    detected = detectEncoding(data, length, &bomLength);
+    if (detected == Encoding::Unknown) {
+        error = "无法识别文件编码（支持UTF-8、UTF-16、GB18030/GBK和Big5）";
+        return false;
+    }
+    if (detected == Encoding::Gb18030 || detected == Encoding::Big5) {
+        // 双字节编码几乎能解码任意字节，先试解码采样，解码出错的不接受
+        QStringDecoder decoder = makeDecoder(detected);
+        if (decoder.isValid()) {
+            const QString decoded = decoder.decode(QByteArrayView(data, qMin(length, kSampleBytes)));
+            if (decoder.hasError() || decoded.contains(QChar::ReplacementCharacter)) {
+                error = QString("文件内容与检测到的编码 %1 不符").arg(encodingName());
+                return false;
+            }
+        }
+    }
+    const qsizetype payload = length - bomLength;
+    if (detected == Encoding::Utf8) {
+        // 校验的同时得到解码后的长度，调用方据此一次分配到位
+        if (!isValidUtf8(data + bomLength, payload, &decodedSize)) {
+            error = "文件不是有效的UTF-8编码，可能已损坏";
+            return false;
+        }
+    }
+    else if (detected == Encoding::Utf16LE || detected == Encoding::Utf16BE) {
+        decodedSize = payload / 2;
+    }
+    else {
+        decodedSize = payload;
+    }
+    return true;
+}
+
+void MappedTextReader::close()
+{
+    if (data && fallbackBuffer.isEmpty()) {
+        file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+    }
+    data = nullptr;
+    length = 0;
+    decodedSize = 0;
+    fallbackBuffer.clear();
+    file.close();
+}
+
+MappedTextReader::Encoding MappedTextReader::encoding() const
+{
+    return detected;
+}
+
+QString MappedTextReader::encodingName() const
+{
+    return encodingName(detected);
+}
+
+qint64 MappedTextReader::size() const
+{
+    return length;
+}
+
+qsizetype MappedTextReader::decodedLength() const
+{
+    return decodedSize;
+}
+
+QString MappedTextReader::errorString() const
+{
+    return error;
+}
+
+QString MappedTextReader::encodingName(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Utf8: return "UTF-8";
+    case Encoding::Utf16LE: return "UTF-16LE";
+    case Encoding::Utf16BE: return "UTF-16BE";
+    case Encoding::Gb18030: return "GB18030";
+    case Encoding::Big5: return "Big5";
+    default: return QString();
+    }
+}
+
+bool MappedTextReader::isValidUtf8(const char* data, qsizetype length, qsizetype* utf16Length)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    qsizetype units = 0;
+
+    while (p < end) {
+        // 大部分文本是ASCII，先成块跳过
+        const unsigned char* ascii = p;
+        p = skipAscii(p, end);
+        units += p - ascii;
+        if (p >= end) {
+            break;
+        }
+
+        const unsigned char lead = *p;
+        int extra = 0;
+        quint32 code = 0;
+        quint32 minCode = 0;
+        if ((lead & 0xE0) == 0xC0) {
+            extra = 1;
+            code = lead & 0x1F;
+            minCode = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0) {
+            extra = 2;
+            code = lead & 0x0F;
+            minCode = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0) {
+            extra = 3;
+            code = lead & 0x07;
+            minCode = 0x10000;
+        }
+        else {
+            return false;
+        }
+
+        if (end - p <= extra) {
+            return false;
+        }
+        for (int i = 1; i <= extra; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                return false;
+            }
+            code = (code << 6) | (p[i] & 0x3F);
+        }
+
+        // 拒绝过长编码、代理区和超出Unicode范围的码点
+        if (code < minCode || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+            return false;
+        }
+        p += extra + 1;
+        // 基本多文种平面之外的字符占两个UTF-16单元
+        units += extra == 3 ? 2 : 1;
+    }
+    if (utf16Length) {
+        *utf16Length = units;
+    }
+    return true;
+}
+
+MappedTextReader::Encoding MappedTextReader::detectEncoding(const char* data, qsizetype length,
+    qsizetype* bomLength)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (bomLength) {
+        *bomLength = 0;
+    }
+
+    // BOM优先
+    if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+        if (bomLength) {
+            *bomLength = 3;
+        }
+        return Encoding::Utf8;
+    }
+    if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+        if (bomLength) {
+            *bomLength = 2;
+        }
+        return Encoding::Utf16LE;
+    }
+    if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+        if (bomLength) {
+            *bomLength = 2;
+        }
+        return Encoding::Utf16BE;
+    }
+
+    const qsizetype sample = qMin(length, kSampleBytes);
+    if (sample == 0) {
+        return Encoding::Utf8;
+    }
+
+    // 无BOM的UTF-16：ASCII字符的高字节为0
+    qsizetype evenZeros = 0;
+    qsizetype oddZeros = 0;
+    for (qsizetype i = 0; i + 1 < sample; i += 2) {
+        evenZeros += bytes[i] == 0;
+        oddZeros += bytes[i + 1] == 0;
+    }
+    const qsizetype pairs = sample / 2;
+    if (pairs > 0 && oddZeros * 10 > pairs * 3 && oddZeros > evenZeros * 4) {
+        return Encoding::Utf16LE;
+    }
+    if (pairs > 0 && evenZeros * 10 > pairs * 3 && evenZeros > oddZeros * 4) {
+        return Encoding::Utf16BE;
+    }
+
+    if (isValidUtf8(data, utf8SampleBoundary(bytes, sample))) {
+        return Encoding::Utf8;
+    }
+
+    // 双字节编码：GB2312常用字的尾字节都在0xA1以上，Big5常用字的尾字节大量落在0x40-0x7E
+    qsizetype doubleBytes = 0;
+    qsizetype lowTrail = 0;
+    for (qsizetype i = 0; i + 1 < sample; ++i) {
+        if (bytes[i] < 0x81 || bytes[i] == 0xFF) {
+            continue;
+        }
+        ++doubleBytes;
+        lowTrail += bytes[i + 1] >= 0x40 && bytes[i + 1] <= 0x7E;
+        ++i;
+    }
+
+    // 先按尾字节分布选出候选，候选的字节结构或常用字比例不符时再试另一种；
+    // Latin-1、Shift-JIS等其他编码通常两者都不符合
+    const bool preferBig5 = doubleBytes > 0 && lowTrail * 3 > doubleBytes;
+    const Encoding candidates[] = {
+        preferBig5 ? Encoding::Big5 : Encoding::Gb18030,
+        preferBig5 ? Encoding::Gb18030 : Encoding::Big5
+    };
+    for (Encoding candidate : candidates) {
+        if (doubleByteScore(bytes, sample, candidate == Encoding::Big5) >= kMinCommonRatio) {
+            return candidate;
+        }
+    }
+    return Encoding::Unknown;
+}
+
+QStringDecoder MappedTextReader::makeDecoder(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Utf8: return QStringDecoder(QStringDecoder::Utf8);
+    case Encoding::Utf16LE: return QStringDecoder(QStringDecoder::Utf16LE);
+    case Encoding::Utf16BE: return QStringDecoder(QStringDecoder::Utf16BE);
+    case Encoding::Gb18030: return QStringDecoder("GB18030");
+    case Encoding::Big5: return QStringDecoder("Big5");
+    default: return QStringDecoder();
+    }
+}
+
+bool MappedTextReader::decode(const std::function<bool(QStringView)>& sink, qsizetype chunkBytes)
+{
+    QStringDecoder decoder = makeDecoder(detected);
+
+    if (!decoder.isValid()) {
+        error = QString("当前Qt版本不支持编码: %1").arg(encodingName());
+        return false;
+    }
+
+    // 解码缓冲区在各块之间复用
+    QString buffer;
+    for (qsizetype pos = bomLength; pos < length; pos += chunkBytes) {
+        QByteArrayView chunk(data + pos, qMin(chunkBytes, length - pos));
+        buffer.resize(decoder.requiredSpace(chunk.size()));
+        QChar* end = decoder.appendToBuffer(buffer.data(), chunk);
+        if (decoder.hasError()) {
+            error = QString("文件内容与检测到的编码 %1 不符").arg(encodingName());
+            return false;
+        }
+        if (!sink(QStringView(buffer.constData(), end - buffer.constData()))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MappedTextReader::readAll(QString& content)
+{
+    content.clear();
+    content.reserve(decodedLength());
+    return decode([&content](QStringView chunk) {
+        content += chunk;
+        return true;
+    });
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+﻿#ifndef MAPPEDTEXTREADER_H
+#define MAPPEDTEXTREADER_H
+
+#include <QString>
+#include <QStringView>
+#include <QByteArray>
+#include <QFile>
+#include <QStringDecoder>
+#include <functional>
+
+// 文本输入读取器：
+// - 内存映射整个文件，不先拷贝到QByteArray
+// - 根据BOM和采样判断编码（UTF-8/UTF-16/GB18030/Big5）；双字节编码须通过字节结构、
+//   常用字比例和试解码检查，都不符合时（如Latin-1、Shift-JIS）报错而不是按GB18030解码
+// - UTF-8在解码前整体校验，乱码文件在进入流水线前就被拒绝
+// - 分块解码，每块直接交给调用方
+class MappedTextReader
+{
+public:
+    enum class Encoding {
+        Unknown,
+        Utf8,
+        Utf16LE,
+        Utf16BE,
+        Gb18030,
+        Big5
+    };
+
+    explicit MappedTextReader(const QString& filePath);
+    ~MappedTextReader();
+
+    bool open();
+    void close();
+
+    Encoding encoding() const;
+    QString encodingName() const;
+    qint64 size() const;
+    // 解码后的UTF-16长度：UTF-8和UTF-16为精确值，双字节编码为上限
+    qsizetype decodedLength() const;
+    QString errorString() const;
+
+    // 按块解码，sink返回false时停止；chunkBytes为每块的原始字节数
+    bool decode(const std::function<bool(QStringView)>& sink, qsizetype chunkBytes = 4 * 1024 * 1024);
+    bool readAll(QString& content);
+
+    // utf16Length不为空时同时统计解码后的UTF-16长度
+    static bool isValidUtf8(const char* data, qsizetype length, qsizetype* utf16Length = nullptr);
+    // 无法识别时返回Unknown
+    static Encoding detectEncoding(const char* data, qsizetype length, qsizetype* bomLength = nullptr);
+    static QString encodingName(Encoding encoding);
+
+private:
+    static QStringDecoder makeDecoder(Encoding encoding);
+
+    QFile file;
+    const char* data;
+    qsizetype length;
+    QByteArray fallbackBuffer;
+    Encoding detected;
+    qsizetype bomLength;
+    qsizetype decodedSize;
+    QString error;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+﻿#include "MemoryBudget.h"
+#include <QElapsedTimer>
+
+namespace {
+    // 默认预算512MB
+    const qint64 kDefaultLimitBytes = 512LL * 1024 * 1024;
+    // 等待期间检查取消标志的间隔
+    const unsigned long kWaitSliceMs = 100;
+    // 等待期间这么久没有任何内存被释放，视为无法继续
+    const qint64 kStallTimeoutMs = 30 * 1000;
+}
+
+MemoryBudget& MemoryBudget::instance()
+{
+    static MemoryBudget budget;
+    return budget;
+}
+
+MemoryBudget::MemoryBudget()
+    : releaseCount(0)
+    , limitBytes(kDefaultLimitBytes)
+    , usedBytes(0)
+{
+}
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    limitBytes = bytes;
+    released.wakeAll();
+}
+
+qint64 MemoryBudget::limit() const
+{
+    QMutexLocker locker(&mutex);
+    return limitBytes;
+}
+
+qint64 MemoryBudget::used() const
+{
+    QMutexLocker locker(&mutex);
+    return usedBytes;
+}
+
+bool MemoryBudget::canAdmit(const void* owner, qint64 bytes) const
+{
+    if (usedBytes + bytes <= limitBytes) {
+        return true;
+    }
+    // 可回收的占用已经回收过；同样在等待预算的任务不会先释放内存，互相等待只会一起卡住。
+    // 其余任务都没有占用内存时，等待也不会有内存被释放
+    qint64 others = usedBytes - usage.value(owner);
+    for (auto it = usage.constBegin(); it != usage.constEnd(); ++it) {
+        if (it.key() != owner
+            && (reclaimers.contains(it.key()) || waiting.value(it.key()) > 0)) {
+            others -= it.value();
+        }
+    }
+    return others <= 0;
+}
+
+bool MemoryBudget::reclaim(qint64 bytes, QMutexLocker<QMutex>& locker)
+{
+    bool reclaimable = false;
+    for (auto it = reclaimers.constBegin(); it != reclaimers.constEnd() && !reclaimable; ++it) {
+        reclaimable = usage.value(it.key()) > 0;
+    }
+    if (!reclaimable) {
+        return false;
+    }
+
+    // 回收函数会调用release，不能持有预算锁
+    const qint64 before = usedBytes;
+    locker.unlock();
+    {
+        QMutexLocker reclaimLocker(&reclaimMutex);
+        for (const auto& reclaimer : reclaimers) {
+            reclaimer(bytes);
+        }
+    }
+    locker.relock();
+    return usedBytes < before;
+}
+
+bool MemoryBudget::acquire(const void* owner, qint64 bytes, const std::atomic_bool* cancelled,
+    QString* error)
+{
+    QMutexLocker locker(&mutex);
+    if (usedBytes + bytes > limitBytes) {
+        ++waiting[owner];
+        quint64 seenReleases = releaseCount;
+        QElapsedTimer stalled;
+        stalled.start();
+
+        bool admitted = false;
+        while (usedBytes + bytes > limitBytes) {
+            // 先收缩缓存，仍然不够时再按占用情况决定放行或等待
+            if (reclaim(usedBytes + bytes - limitBytes, locker)) {
+                continue;
+            }
+            if (canAdmit(owner, bytes)) {
+                admitted = true;
+                break;
+            }
+            if (cancelled && *cancelled) {
+                break;
+            }
+            if (releaseCount != seenReleases) {
+                seenReleases = releaseCount;
+                stalled.restart();
+            }
+            else if (stalled.elapsed() >= kStallTimeoutMs) {
+                // 其他任务保留着译文（例如界面中未保存的文档）且不再释放
+                if (error) {
+                    *error = QString("内存预算不足（%1 MB），其他文档占用的内存长时间未释放，"
+                        "请关闭或保存其他文档，或调大内存预算").arg(limitBytes / (1024 * 1024));
+                }
+                break;
+            }
+            released.wait(&mutex, kWaitSliceMs);
+        }
+
+        if (--waiting[owner] == 0) {
+            waiting.remove(owner);
+        }
+        if (!admitted && usedBytes + bytes > limitBytes) {
+            return false;
+        }
+    }
+
+    usage[owner] += bytes;
+    usedBytes += bytes;
+    return true;
+}
+
+void MemoryBudget::charge(const void* owner, qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    usage[owner] += bytes;
+    usedBytes += bytes;
+}
+
+void MemoryBudget::release(const void* owner, qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    auto it = usage.find(owner);
+    if (it == usage.end()) {
+        return;
+    }
+
+    bytes = qMin(bytes, it.value());
+    it.value() -= bytes;
+    usedBytes -= bytes;
+    if (it.value() == 0) {
+        usage.erase(it);
+    }
+    ++releaseCount;
+    released.wakeAll();
+}
+
+void MemoryBudget::releaseAll(const void* owner)
+{
+    QMutexLocker locker(&mutex);
+    usedBytes -= usage.take(owner);
+    ++releaseCount;
+    released.wakeAll();
+}
+
+void MemoryBudget::setReclaimer(const void* owner, std::function<void(qint64)> reclaim)
+{
+    QMutexLocker reclaimLocker(&reclaimMutex);
+    QMutexLocker locker(&mutex);
+    reclaimers.insert(owner, std::move(reclaim));
+}
+
+void MemoryBudget::removeReclaimer(const void* owner)
+{
+    // 等待正在进行的回收结束
+    QMutexLocker reclaimLocker(&reclaimMutex);
+    QMutexLocker locker(&mutex);
+    reclaimers.remove(owner);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+﻿#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// 进程级内存预算：所有文档存储共用，超出预算时申请方阻塞等待，实现反压。
+// 缓存等可回收的占用方注册回收函数，申请方等待之前先要求它们释放内存。
+// 只等待还能释放内存的占用方：同样在等待预算的占用方不计入；
+// 长时间没有任何内存被释放时申请失败并给出原因，不会无限期等待
+class MemoryBudget
+{
+public:
+    static MemoryBudget& instance();
+
+    void setLimit(qint64 bytes);
+    qint64 limit() const;
+    qint64 used() const;
+
+    // 阻塞直到预算允许或被取消；只有自己占用内存时总是放行，避免单个任务自锁。
+    // 被取消时返回false且error为空；无法继续时返回false并通过error给出原因
+    bool acquire(const void* owner, qint64 bytes, const std::atomic_bool* cancelled = nullptr,
+        QString* error = nullptr);
+    // 不等待，直接记账（用于不能阻塞的界面线程）
+    void charge(const void* owner, qint64 bytes);
+    void release(const void* owner, qint64 bytes);
+    void releaseAll(const void* owner);
+
+    // 回收函数在申请方线程上调用，参数为需要释放的字节数，通过release归还
+    void setReclaimer(const void* owner, std::function<void(qint64)> reclaim);
+    void removeReclaimer(const void* owner);
+
+private:
+    MemoryBudget();
+    bool canAdmit(const void* owner, qint64 bytes) const;
+    // 调用时持有locker，返回是否释放了内存
+    bool reclaim(qint64 bytes, QMutexLocker<QMutex>& locker);
+
+    mutable QMutex mutex;
+    QWaitCondition released;
+    QHash<const void*, qint64> usage;
+    // 正在acquire中等待的线程数，按占用方统计
+    QHash<const void*, int> waiting;
+    // 累计释放次数，用于判断等待期间是否有进展
+    quint64 releaseCount;
+    // 回收期间持有，保证回收函数不会在占用方析构后被调用
+    QMutex reclaimMutex;
+    QHash<const void*, std::function<void(qint64)>> reclaimers;
+    qint64 limitBytes;
+    qint64 usedBytes;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,256 @@
+﻿#include "OrderedFileWriter.h"
+#include <QDebug>
+#include <QFileInfo>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    // 写盘缓冲区大小
+    const qsizetype kBufferBytes = 4 * 1024 * 1024;
+}
+
+OrderedFileWriter::OrderedFileWriter(const QString& filePath, SyncPolicy policy)
+    : filePath(filePath)
+    , file(QFileInfo(filePath).absoluteFilePath() + ".XXXXXX")
+    , committed(false)
+    , syncPolicy(policy)
+    , encoder(QStringEncoder::Utf8)
+    , bufferUsed(0)
+    , next(0)
+    , expected(-1)
+    , failed(false)
+{
+}
+
+OrderedFileWriter::~OrderedFileWriter()
+{
+    // 未提交的临时文件直接丢弃
+    cancel();
+}
+
+bool OrderedFileWriter::open()
+{
+    QMutexLocker locker(&mutex);
+    if (!file.open()) {
+        fail(file.errorString());
+        return false;
+    }
+    file.setTextModeEnabled(true);
+
+    buffer.resize(kBufferBytes);
+    bufferUsed = 0;
+    return true;
+}
+
+void OrderedFileWriter::setSeparator(const QString& text)
+{
+    QMutexLocker locker(&mutex);
+    separator = text;
+}
+
+void OrderedFileWriter::setExpectedCount(int count)
+{
+    QMutexLocker locker(&mutex);
+    expected = count;
+}
+
+int OrderedFileWriter::expectedCount() const
+{
+    QMutexLocker locker(&mutex);
+    return expected;
+}
+
+bool OrderedFileWriter::write(int index, QStringView text)
+{
+    QMutexLocker locker(&mutex);
+    if (failed || !file.isOpen() || index < next || pending.contains(index)) {
+        return false;
+    }
+    if (index < 0 || (expected >= 0 && index >= expected)) {
+        // 超出总数的分段永远无法按顺序写出，立即拒绝而不是留到提交时才失败
+        error = QString("分段序号 %1 超出分段总数 %2").arg(index).arg(expected);
+        return false;
+    }
+
+    if (index != next) {
+        // 还没轮到，先放入重排窗口
+        pending.insert(index, text.toString());
+        return true;
+    }
+
+    if (!appendInOrder(text)) {
+        return false;
+    }
+
+    // 依次写出窗口中已经连续的分段
+    auto it = pending.begin();
+    while (it != pending.end() && it.key() == next) {
+        if (!appendInOrder(it.value())) {
+            return false;
+        }
+        it = pending.erase(it);
+    }
+    return true;
+}
+
+int OrderedFileWriter::nextIndex() const
+{
+    QMutexLocker locker(&mutex);
+    return next;
+}
+
+int OrderedFileWriter::pendingCount() const
+{
+    QMutexLocker locker(&mutex);
+    return pending.size();
+}
+
+bool OrderedFileWriter::isWritten(int index) const
+{
+    QMutexLocker locker(&mutex);
+    return index < next || pending.contains(index);
+}
+
+int OrderedFileWriter::writtenCount() const
+{
+    QMutexLocker locker(&mutex);
+    return next + pending.size();
+}
+
+bool OrderedFileWriter::appendInOrder(QStringView text)
+{
+    if (next > 0 && !separator.isEmpty() && !encode(separator)) {
+        return false;
+    }
+    if (!encode(text)) {
+        return false;
+    }
+    ++next;
+    return true;
+}
+
+bool OrderedFileWriter::encode(QStringView text)
+{
+    qsizetype required = encoder.requiredSpace(text.size());
+    if (bufferUsed + required > buffer.size() && !flushBuffer()) {
+        return false;
+    }
+
+    if (required > buffer.size()) {
+        // 超过缓冲区大小的分段直接编码写出
+        QByteArray encoded = encoder.encode(text);
+        if (file.write(encoded) != encoded.size()) {
+            fail(file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    char* end = encoder.appendToBuffer(buffer.data() + bufferUsed, text);
+    bufferUsed = end - buffer.constData();
+    return true;
+}
+
+bool OrderedFileWriter::flushBuffer()
+{
+    if (bufferUsed == 0) {
+        return true;
+    }
+
+    if (file.write(buffer.constData(), bufferUsed) != bufferUsed) {
+        fail(file.errorString());
+        return false;
+    }
+    bufferUsed = 0;
+
+    if (syncPolicy == SyncPolicy::EveryFlush) {
+        return syncToDisk();
+    }
+    return true;
+}
+
+bool OrderedFileWriter::syncToDisk()
+{
+    if (!file.flush()) {
+        fail(file.errorString());
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    int result = _commit(file.handle());
+#else
+    int result = ::fsync(file.handle());
+#endif
+    if (result != 0) {
+        fail("同步到磁盘失败");
+        return false;
+    }
+    return true;
+}
+
+bool OrderedFileWriter::commit()
+{
+    QMutexLocker locker(&mutex);
+    if (failed || !file.isOpen()) {
+        return false;
+    }
+
+    if (!pending.isEmpty() || (expected >= 0 && next != expected)) {
+        fail(QString("缺少分段 %1，无法提交").arg(next));
+        return false;
+    }
+
+    if (!flushBuffer()) {
+        return false;
+    }
+    if (syncPolicy != SyncPolicy::Never && !syncToDisk()) {
+        return false;
+    }
+
+    // 临时文件创建时只有所有者可读写，改为与目标文件相同（目标不存在时为常规文件）的权限
+    const QFile::Permissions permissions = QFile::exists(filePath)
+        ? QFile::permissions(filePath)
+        : QFile::ReadOwner | QFile::WriteOwner | QFile::ReadUser | QFile::WriteUser
+            | QFile::ReadGroup | QFile::ReadOther;
+    file.setPermissions(permissions);
+
+    // 改名覆盖目标文件，读取方只会看到旧文件或完整的新文件
+    if (!file.rename(filePath)) {
+        fail(file.errorString());
+        return false;
+    }
+    file.setAutoRemove(false);
+    committed = true;
+    return true;
+}
+
+void OrderedFileWriter::cancel()
+{
+    QMutexLocker locker(&mutex);
+    if (!committed) {
+        // 未提交的临时文件直接删除
+        file.remove();
+    }
+    pending.clear();
+    bufferUsed = 0;
+}
+
+QString OrderedFileWriter::errorString() const
+{
+    QMutexLocker locker(&mutex);
+    return error;
+}
+
+void OrderedFileWriter::fail(const QString& message)
+{
+    failed = true;
+    error = message;
+    qDebug() << "写入文件失败:" << filePath << message;
+    if (!committed) {
+        file.remove();
+    }
+}
\ No newline at end of file
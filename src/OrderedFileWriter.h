@@ -0,0 +1,72 @@
+﻿#ifndef ORDEREDFILEWRITER_H
+#define ORDEREDFILEWRITER_H
+
+#include <QString>
+#include <QStringView>
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QTemporaryFile>
+#include <QStringEncoder>
+
+// 按分段序号顺序写出的输出文件：
+// - 分段可以乱序到达，只缓存尚未轮到的分段
+// - 直接编码为UTF-8写入大块缓冲区，缓冲区满后再写盘
+// - 先写临时文件，commit时原子替换目标文件，中途失败不会留下半个文件
+class OrderedFileWriter
+{
+public:
+    enum class SyncPolicy {
+        OnCommit,   // 仅在提交时同步到磁盘
+        EveryFlush, // 每次写出缓冲区后都同步
+        Never       // 从不主动同步，只保证原子替换；用于吞吐测试，断电时可能丢失内容
+    };
+
+    explicit OrderedFileWriter(const QString& filePath, SyncPolicy policy = SyncPolicy::OnCommit);
+    ~OrderedFileWriter();
+
+    bool open();
+    void setSeparator(const QString& separator);
+    // 应写入的分段总数；设置后commit检查末尾是否有未写入的分段
+    void setExpectedCount(int count);
+    int expectedCount() const;
+
+    // 线程安全；index从0开始且每个序号只能写一次，设置了总数时不能超出
+    bool write(int index, QStringView text);
+    int nextIndex() const;
+    int pendingCount() const;
+    // 已写入（包括在重排窗口中等待）的分段，用于暂停后从断点继续
+    bool isWritten(int index) const;
+    int writtenCount() const;
+
+    // 写入剩余缓冲并原子替换目标文件；仍有缺失的分段（包括末尾未写入的）时失败
+    bool commit();
+    void cancel();
+
+    QString errorString() const;
+
+private:
+    bool appendInOrder(QStringView text);
+    bool encode(QStringView text);
+    bool flushBuffer();
+    bool syncToDisk();
+    void fail(const QString& message);
+
+    mutable QMutex mutex;
+    QString filePath;
+    // 目标文件所在目录中的临时文件，提交时改名覆盖目标文件
+    QTemporaryFile file;
+    bool committed;
+    SyncPolicy syncPolicy;
+    QStringEncoder encoder;
+    QByteArray buffer;
+    qsizetype bufferUsed;
+    QMap<int, QString> pending;
+    QString separator;
+    int next;
+    int expected;
+    bool failed;
+    QString error;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,133 @@
+﻿#include "PlaceholderMasker.h"
+#include <QVector>
+#include <QCryptographicHash>
+#include <algorithm>
+
+namespace {
+    const QChar kOpen(0x27E6);   // ⟦
+    const QChar kClose(0x27E7);  // ⟧
+
+    const char* const kCodePattern = "(?<code>`[^`\\n]+`)";
+    const char* const kUrlPattern = "(?<url>(?:https?|ftp)://[^\\s<>\"'`]*[^\\s<>\"'`.,;:!?)\\]}])";
+    const char* const kNumberPattern = "(?<number>(?<![\\w.])\\d++(?:[.,:]\\d++)*+%?)";
+    // 原文中本来就有的占位符括号也要保护，否则还原时会被误认
+    const char* const kBracketPattern = "(?<bracket>[\\x{27E6}\\x{27E7}])";
+}
+
+PlaceholderMasker::PlaceholderMasker(const QMap<QString, QString>& glossary)
+{
+    // 长术语优先，避免被其中包含的短术语截断
+    QStringList keys = glossary.keys();
+    std::sort(keys.begin(), keys.end(), [](const QString& a, const QString& b) {
+        return a.length() > b.length();
+    });
+
+    QStringList alternatives = { kCodePattern, kUrlPattern };
+    if (!keys.isEmpty()) {
+        QStringList escaped;
+        for (const QString& key : keys) {
+            escaped << QRegularExpression::escape(key);
+            terms.insert(key.toLower(), glossary.value(key));
+        }
+        alternatives << "(?<term>\\b(?:" + escaped.join('|') + ")\\b)";
+    }
+    alternatives << kNumberPattern << kBracketPattern;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (auto it = glossary.constBegin(); it != glossary.constEnd(); ++it) {
+        hash.addData((it.key() + '\x1f' + it.value() + '\n').toUtf8());
+    }
+    version = QString::fromLatin1(hash.result().toHex().left(16));
+
+    pattern.setPattern(alternatives.join('|'));
+    pattern.setPatternOptions(QRegularExpression::CaseInsensitiveOption
+        | QRegularExpression::UseUnicodePropertiesOption);
+    pattern.optimize();
+}
+
+PlaceholderMasker::Masked PlaceholderMasker::mask(const QString& text) const
+{
+    Masked masked;
+    masked.text.reserve(text.length());
+
+    // 相同内容共用一个占位符
+    QHash<QString, int> indices;
+    qsizetype last = 0;
+    QRegularExpressionMatchIterator it = pattern.globalMatch(text);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        const QString original = match.captured(0);
+
+        QString replacement = original;
+        if (match.capturedStart("term") >= 0) {
+            replacement = terms.value(original.toLower(), original);
+        }
+
+        auto found = indices.constFind(replacement);
+        int index = 0;
+        if (found != indices.constEnd()) {
+            index = found.value();
+        }
+        else {
+            index = masked.replacements.size();
+            masked.replacements << replacement;
+            indices.insert(replacement, index);
+        }
+
+        masked.text += QStringView(text).mid(last, match.capturedStart(0) - last);
+        masked.text += kOpen;
+        masked.text += QString::number(index);
+        masked.text += kClose;
+        last = match.capturedEnd(0);
+    }
+
+    if (masked.replacements.isEmpty()) {
+        masked.text = text;
+    }
+    else {
+        masked.text += QStringView(text).mid(last);
+    }
+    return masked;
+}
+
+QString PlaceholderMasker::glossaryVersion() const
+{
+    return version;
+}
+
+bool PlaceholderMasker::restore(QString& text, const QStringList& replacements)
+{
+    if (replacements.isEmpty()) {
+        return true;
+    }
+
+    QString restored;
+    restored.reserve(text.length());
+    QVector<bool> seen(replacements.size(), false);
+
+    qsizetype last = 0;
+    qsizetype open = text.indexOf(kOpen);
+    while (open >= 0) {
+        const qsizetype close = text.indexOf(kClose, open + 1);
+        if (close < 0) {
+            break;
+        }
+
+        bool ok = false;
+        const int index = QStringView(text).mid(open + 1, close - open - 1).toInt(&ok);
+        if (ok && index >= 0 && index < replacements.size()) {
+            restored += QStringView(text).mid(last, open - last);
+            restored += replacements.at(index);
+            seen[index] = true;
+            last = close + 1;
+            open = text.indexOf(kOpen, last);
+        }
+        else {
+            open = text.indexOf(kOpen, open + 1);
+        }
+    }
+
+    restored += QStringView(text).mid(last);
+    text = std::move(restored);
+    return !seen.contains(false);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+﻿#ifndef PLACEHOLDERMASKER_H
+#define PLACEHOLDERMASKER_H
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QMap>
+#include <QHash>
+#include <QRegularExpression>
+
+// 发送前把术语、数字、URL和行内代码替换为占位符⟦n⟧，收到译文后再还原
+// 术语还原为词典中的译法，其余还原为原文；构造后只读，可在多个线程中共用
+class PlaceholderMasker
+{
+public:
+    struct Masked {
+        QString text;
+        // 第n个占位符还原后的文本
+        QStringList replacements;
+    };
+
+    explicit PlaceholderMasker(const QMap<QString, QString>& glossary = QMap<QString, QString>());
+
+    Masked mask(const QString& text) const;
+    // 译文中缺少任一占位符时返回false，调用方应视为翻译失败
+    static bool restore(QString& text, const QStringList& replacements);
+
+    // 词典内容的摘要，词典变化后缓存的译文随之失效
+    QString glossaryVersion() const;
+
+private:
+    QRegularExpression pattern;
+    QString version;
+    // 键为小写术语
+    QHash<QString, QString> terms;
+};
+
+#endif
\ No newline at end of file
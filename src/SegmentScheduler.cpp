@@ -0,0 +1,56 @@
+﻿#include "SegmentScheduler.h"
+
+SegmentScheduler::SegmentScheduler(QVector<int> requestOfSegment, int requestCount, int trackCount)
+    : requestOfSegment(std::move(requestOfSegment))
+    , trackCount(trackCount)
+    , claimed(requestCount * trackCount, false)
+    , cursor(0)
+{
+}
+
+bool SegmentScheduler::take(int first, int last, int& request, int& track)
+{
+    QMutexLocker locker(&mutex);
+
+    if (first >= 0 && last >= first && !requestOfSegment.isEmpty()) {
+        // 可见范围加上其下方一屏，按阅读顺序领取
+        const int end = qMin(last + (last - first + 1), static_cast<int>(requestOfSegment.size()) - 1);
+        int previous = -1;
+        for (int segment = first; segment <= end; ++segment) {
+            const int candidate = requestOfSegment.at(segment);
+            if (candidate == previous) {
+                continue;
+            }
+            previous = candidate;
+            if (claimRequest(candidate, track)) {
+                request = candidate;
+                return true;
+            }
+        }
+    }
+
+    // 其余单元按文档顺序领取
+    while (cursor < claimed.size() && claimed.at(cursor)) {
+        ++cursor;
+    }
+    if (cursor == claimed.size()) {
+        return false;
+    }
+    claimed[cursor] = true;
+    request = cursor / trackCount;
+    track = cursor % trackCount;
+    return true;
+}
+
+bool SegmentScheduler::claimRequest(int request, int& track)
+{
+    for (int t = 0; t < trackCount; ++t) {
+        const int unit = request * trackCount + t;
+        if (!claimed.at(unit)) {
+            claimed[unit] = true;
+            track = t;
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+﻿#ifndef SEGMENTSCHEDULER_H
+#define SEGMENTSCHEDULER_H
+
+#include <QVector>
+#include <QMutex>
+
+// 文档翻译的工作单元分配：工作线程每次领取一个（请求，语言）单元。
+// 优先领取覆盖可见分段及其下方一屏的请求，其余单元按文档顺序由空闲线程领取
+class SegmentScheduler
+{
+public:
+    // requestOfSegment[i]为第i个分段所属的请求（重复分段指向首次出现所在的请求）
+    SegmentScheduler(QVector<int> requestOfSegment, int requestCount, int trackCount);
+
+    // first/last为可见分段范围，first < 0表示没有提示
+    bool take(int first, int last, int& request, int& track);
+
+private:
+    bool claimRequest(int request, int& track);
+
+    QMutex mutex;
+    QVector<int> requestOfSegment;
+    int trackCount;
+    // 单元序号为request * trackCount + track，与按请求轮转各语言的顺序一致
+    QVector<bool> claimed;
+    int cursor;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,272 @@
+﻿#include "SegmentStore.h"
+#include "MemoryBudget.h"
+
+SegmentStore::SegmentStore(QObject* parent)
+    : QObject(parent)
+    , targetLanguages({ QString() })
+    , currentGeneration(0)
+    , dirtyFirst(-1)
+    , dirtyLast(-1)
+{
+}
+
+SegmentStore::~SegmentStore()
+{
+    MemoryBudget::instance().releaseAll(this);
+}
+
+void SegmentStore::setSource(QString text, QVector<TextSpan> spans)
+{
+    {
+        QWriteLocker locker(&lock);
+        MemoryBudget::instance().releaseAll(this);
+        targetArena.clear();
+
+        sourceText = std::move(text);
+        sourceSpans = std::move(spans);
+        resetTracks();
+
+        // 原文在界面线程加载，只记账不等待；反压作用于译文写入
+        MemoryBudget::instance().charge(this,
+            sourceText.size() * qint64(sizeof(QChar))
+            + sourceSpans.size() * qint64(sizeof(TextSpan)));
+    }
+    emit segmentsReset();
+}
+
+void SegmentStore::clear()
+{
+    setSource(QString(), QVector<TextSpan>());
+}
+
+void SegmentStore::clearTargets()
+{
+    {
+        QWriteLocker locker(&lock);
+        releaseTargets();
+        resetTracks();
+    }
+    emit segmentsReset();
+}
+
+void SegmentStore::setTargetLanguages(const QStringList& languages)
+{
+    {
+        QWriteLocker locker(&lock);
+        releaseTargets();
+        targetLanguages = languages.isEmpty() ? QStringList({ QString() }) : languages;
+        resetTracks();
+    }
+    emit segmentsReset();
+}
+
+int SegmentStore::trackCount() const
+{
+    QReadLocker locker(&lock);
+    return targetLanguages.size();
+}
+
+QString SegmentStore::trackLanguage(int track) const
+{
+    QReadLocker locker(&lock);
+    return targetLanguages.value(track);
+}
+
+void SegmentStore::releaseTargets()
+{
+    MemoryBudget::instance().release(this, targetArena.allocatedBytes());
+    targetArena.clear();
+}
+
+void SegmentStore::resetTracks()
+{
+    targetRefs = QVector<QVector<TextArena::Ref>>(targetLanguages.size(),
+        QVector<TextArena::Ref>(sourceSpans.size()));
+    releasedCounts = QVector<int>(targetLanguages.size(), 0);
+    ++currentGeneration;
+    dirtyFirst = -1;
+    dirtyLast = -1;
+}
+
+int SegmentStore::count() const
+{
+    QReadLocker locker(&lock);
+    return sourceSpans.size();
+}
+
+QString SegmentStore::source(int index) const
+{
+    return sourceView(index).toString();
+}
+
+QStringView SegmentStore::sourceView(int index) const
+{
+    QReadLocker locker(&lock);
+    if (index < 0 || index >= sourceSpans.size()) {
+        return QStringView();
+    }
+    const TextSpan& span = sourceSpans.at(index);
+    return QStringView(sourceText).mid(span.offset, span.length);
+}
+
+void SegmentStore::snapshotSource(QString& text, QVector<TextSpan>& spans,
+    quint64& generation) const
+{
+    QReadLocker locker(&lock);
+    text = sourceText;
+    spans = sourceSpans;
+    generation = currentGeneration;
+}
+
+quint64 SegmentStore::generation() const
+{
+    QReadLocker locker(&lock);
+    return currentGeneration;
+}
+
+QString SegmentStore::target(int index, int track) const
+{
+    QReadLocker locker(&lock);
+    if (track < 0 || track >= targetRefs.size()
+        || index < 0 || index >= targetRefs[track].size()) {
+        return QString();
+    }
+    return targetArena.view(targetRefs[track].at(index)).toString();
+}
+
+bool SegmentStore::hasTarget(int index, int track) const
+{
+    QReadLocker locker(&lock);
+    return track >= 0 && track < targetRefs.size()
+        && index >= 0 && index < targetRefs[track].size()
+        && targetRefs[track].at(index).isValid();
+}
+
+bool SegmentStore::setTarget(quint64 generation, int track, int index, QStringView text,
+    const std::atomic_bool* cancelled, QString* error)
+{
+    bool wasClean = false;
+    {
+        QWriteLocker locker(&lock);
+        while (generation == currentGeneration && !targetArena.fits(text.size())) {
+            // 申请新块前释放锁，预算不足时在锁外等待
+            const qint64 bytes = targetArena.blockBytesFor(text.size());
+            locker.unlock();
+            if (!MemoryBudget::instance().acquire(this, bytes, cancelled, error)) {
+                return false;
+            }
+            locker.relock();
+
+            if (generation != currentGeneration) {
+                // 等待期间加载了新文档，这段译文已无处可写
+                MemoryBudget::instance().release(this, bytes);
+                return false;
+            }
+            if (targetArena.fits(text.size())) {
+                // 等待期间其他线程已分配了新块
+                MemoryBudget::instance().release(this, bytes);
+                break;
+            }
+            targetArena.addBlock(text.size());
+        }
+
+        if (generation != currentGeneration || track < 0 || track >= targetRefs.size()
+            || index < 0 || index >= targetRefs[track].size()) {
+            return false;
+        }
+        targetRefs[track][index] = targetArena.append(text);
+
+        wasClean = dirtyFirst < 0;
+        if (wasClean) {
+            dirtyFirst = index;
+            dirtyLast = index;
+        }
+        else {
+            dirtyFirst = qMin(dirtyFirst, index);
+            dirtyLast = qMax(dirtyLast, index);
+        }
+    }
+
+    if (wasClean) {
+        emit targetsChanged();
+    }
+    return true;
+}
+
+void SegmentStore::releaseTargetsBefore(quint64 generation, int track, int index)
+{
+    QWriteLocker locker(&lock);
+    if (generation != currentGeneration || track < 0 || track >= targetRefs.size()) {
+        return;
+    }
+
+    const QVector<TextArena::Ref>& refs = targetRefs[track];
+    int& released = releasedCounts[track];
+    index = qMin(index, int(refs.size()));
+    qint64 freed = 0;
+    for (; released < index; ++released) {
+        freed += targetArena.release(refs.at(released));
+    }
+
+    if (freed > 0) {
+        MemoryBudget::instance().release(this, freed);
+    }
+}
+
+bool SegmentStore::isTargetReleased(int index, int track) const
+{
+    QReadLocker locker(&lock);
+    return index >= 0 && index < releasedCounts.value(track);
+}
+
+QString SegmentStore::joinedSource(const QString& separator) const
+{
+    QReadLocker locker(&lock);
+    QString result;
+    result.reserve(sourceText.size() + sourceSpans.size() * separator.size());
+    for (int i = 0; i < sourceSpans.size(); ++i) {
+        if (i > 0) {
+            result += separator;
+        }
+        result += QStringView(sourceText).mid(sourceSpans[i].offset, sourceSpans[i].length);
+    }
+    return result;
+}
+
+QString SegmentStore::joinedTarget(const QString& separator, int track) const
+{
+    QReadLocker locker(&lock);
+    QString result;
+    if (track < 0 || track >= targetRefs.size()) {
+        return result;
+    }
+
+    const QVector<TextArena::Ref>& refs = targetRefs[track];
+    for (int i = 0; i < refs.size(); ++i) {
+        if (i > 0) {
+            result += separator;
+        }
+        result += targetArena.view(refs[i]);
+    }
+    return result;
+}
+
+qint64 SegmentStore::memoryUsage() const
+{
+    QReadLocker locker(&lock);
+    return sourceText.size() * qint64(sizeof(QChar)) + targetArena.allocatedBytes();
+}
+
+bool SegmentStore::takeDirtyRange(int& first, int& last)
+{
+    QWriteLocker locker(&lock);
+    if (dirtyFirst < 0) {
+        return false;
+    }
+
+    first = dirtyFirst;
+    last = dirtyLast;
+    dirtyFirst = -1;
+    dirtyLast = -1;
+    return true;
+}
\ No newline at end of file
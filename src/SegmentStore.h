@@ -0,0 +1,79 @@
+﻿#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+#include <QReadWriteLock>
+#include <atomic>
+#include "TextArena.h"
+
+// 文档分段存储：原文整体保存在一个缓冲区中，分段只记录位置；
+// 每个目标语言对应一条译文轨道，译文追加到TextArena，占用的内存计入全局MemoryBudget
+class SegmentStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentStore(QObject* parent = nullptr);
+    ~SegmentStore();
+
+    void setSource(QString text, QVector<TextSpan> spans);
+    void clear();
+    void clearTargets();
+    // 设置目标语言并清空译文，每种语言一条轨道
+    void setTargetLanguages(const QStringList& languages);
+    int trackCount() const;
+    QString trackLanguage(int track) const;
+
+    int count() const;
+    QString source(int index) const;
+    // 返回的视图在下一次setSource之前有效
+    QStringView sourceView(int index) const;
+    // 原文与分段位置的快照（原文隐式共享，不复制），以及当前的译文代数；
+    // 后台任务持有快照，即使界面线程随后加载了新文档，视图也保持有效
+    void snapshotSource(QString& text, QVector<TextSpan>& spans, quint64& generation) const;
+    // 每次替换原文或清空译文时加一
+    quint64 generation() const;
+    QString target(int index, int track = 0) const;
+    bool hasTarget(int index, int track = 0) const;
+    // 预算不足时阻塞等待；被取消或代数已变化（译文属于旧文档）时返回false，
+    // 预算长时间无法满足时返回false并通过error给出原因
+    bool setTarget(quint64 generation, int track, int index, QStringView text,
+        const std::atomic_bool* cancelled = nullptr, QString* error = nullptr);
+    // 已写入输出文件的译文可以释放，释放后只保留“已翻译”状态
+    void releaseTargetsBefore(quint64 generation, int track, int index);
+    bool isTargetReleased(int index, int track = 0) const;
+
+    QString joinedSource(const QString& separator = " ") const;
+    QString joinedTarget(const QString& separator = " ", int track = 0) const;
+    qint64 memoryUsage() const;
+
+    // 取出自上次调用以来发生变化的译文范围，没有变化时返回false
+    bool takeDirtyRange(int& first, int& last);
+
+signals:
+    void segmentsReset();
+    // 仅在由“无变化”转为“有变化”时发出一次，避免大量跨线程信号
+    void targetsChanged();
+
+private:
+    void releaseTargets();
+    void resetTracks();
+
+    mutable QReadWriteLock lock;
+    QString sourceText;
+    QVector<TextSpan> sourceSpans;
+    TextArena targetArena;
+    QStringList targetLanguages;
+    QVector<QVector<TextArena::Ref>> targetRefs;
+    QVector<int> releasedCounts;
+    quint64 currentGeneration;
+
+    int dirtyFirst;
+    int dirtyLast;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+﻿#include "SegmentTableModel.h"
+
+namespace {
+    // 每次向视图暴露的行数，滚动到末尾时再继续加载
+    const int kFetchBatchSize = 1000;
+    // 单元格中显示的最大字符数，完整内容通过工具提示查看
+    const int kMaxCellChars = 300;
+
+    QString displayText(const QString& text)
+    {
+        if (text.length() <= kMaxCellChars) {
+            return text;
+        }
+        return text.left(kMaxCellChars) + QStringLiteral("…");
+    }
+}
+
+SegmentTableModel::SegmentTableModel(SegmentStore* store, QObject* parent)
+    : QAbstractTableModel(parent)
+    , store(store)
+    , loadedRows(0)
+    , trackCount(1)
+{
+    connect(store, &SegmentStore::segmentsReset, this, &SegmentTableModel::onSegmentsReset);
+    connect(store, &SegmentStore::targetsChanged, this, &SegmentTableModel::onTargetsChanged,
+        Qt::QueuedConnection);
+
+    onSegmentsReset();
+}
+
+int SegmentTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : loadedRows;
+}
+
+int SegmentTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : TargetColumn + trackCount;
+}
+
+QVariant SegmentTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= loadedRows) {
+        return QVariant();
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) {
+        return QVariant();
+    }
+
+    const int track = index.column() - TargetColumn;
+    if (track >= 0 && store->isTargetReleased(index.row(), track)) {
+        return QStringLiteral("（已写入输出文件）");
+    }
+
+    QString text = index.column() == SourceColumn
+        ? store->source(index.row())
+        : store->target(index.row(), track);
+
+    return role == Qt::DisplayRole ? displayText(text) : text;
+}
+
+QVariant SegmentTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+
+    if (section == SourceColumn) {
+        return QStringLiteral("原文");
+    }
+
+    QString language = store->trackLanguage(section - TargetColumn);
+    if (trackCount == 1 || language.isEmpty()) {
+        return QStringLiteral("译文");
+    }
+    return QString("译文 (%1)").arg(language);
+}
+
+bool SegmentTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && loadedRows < store->count();
+}
+
+void SegmentTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    int remaining = store->count() - loadedRows;
+    int toFetch = qMin(kFetchBatchSize, remaining);
+    if (toFetch <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), loadedRows, loadedRows + toFetch - 1);
+    loadedRows += toFetch;
+    endInsertRows();
+}
+
+void SegmentTableModel::onSegmentsReset()
+{
+    beginResetModel();
+    loadedRows = qMin(kFetchBatchSize, store->count());
+    trackCount = store->trackCount();
+    endResetModel();
+}
+
+void SegmentTableModel::onTargetsChanged()
+{
+    int first = 0;
+    int last = 0;
+    if (!store->takeDirtyRange(first, last) || first >= loadedRows) {
+        return;
+    }
+
+    last = qMin(last, loadedRows - 1);
+    emit dataChanged(index(first, TargetColumn), index(last, TargetColumn + trackCount - 1),
+        { Qt::DisplayRole, Qt::ToolTipRole });
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+﻿#ifndef SEGMENTTABLEMODEL_H
+#define SEGMENTTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include "SegmentStore.h"
+
+// 原文/译文对照表模型：每行一个分段，按需分批暴露行，视图只读取可见行；
+// 多目标语言时每种语言占一列
+class SegmentTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        SourceColumn = 0,
+        TargetColumn  // 第一条译文轨道，其余轨道依次向后排列
+    };
+
+    explicit SegmentTableModel(SegmentStore* store, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private slots:
+    void onSegmentsReset();
+    void onTargetsChanged();
+
+private:
+    SegmentStore* store;
+    int loadedRows;
+    int trackCount;
+};
+
+#endif
\ No newline at end of file
@@ -54,4 +54,24 @@ int Settings::getDomain() const
 void Settings::setDomain(int domain)
 {
     setValue("domain", domain);
+}
+
+qint64 Settings::getMemoryBudgetMb() const
+{
+    return value("memory_budget_mb", 512).toLongLong();
+}
+
+void Settings::setMemoryBudgetMb(qint64 megabytes)
+{
+    setValue("memory_budget_mb", megabytes);
+}
+
+bool Settings::getSpeculativeTranslation() const
+{
+    return value("speculative_translation", true).toBool();
+}
+
+void Settings::setSpeculativeTranslation(bool enabled)
+{
+    setValue("speculative_translation", enabled);
 }
\ No newline at end of file
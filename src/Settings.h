@@ -24,6 +24,10 @@ public:
     void setTargetLanguage(const QString& language);
     int getDomain() const;
     void setDomain(int domain);
+    qint64 getMemoryBudgetMb() const;
+    void setMemoryBudgetMb(qint64 megabytes);
+    bool getSpeculativeTranslation() const;
+    void setSpeculativeTranslation(bool enabled);
 
 private:
     QSettings m_settings;
@@ -0,0 +1,83 @@
+﻿#include "SingleFlight.h"
+
+struct SingleFlight::Flight {
+    QString result;
+    bool done = false;
+    bool succeeded = false;
+};
+
+SingleFlight::SingleFlight()
+    : executed(0)
+    , coalesced(0)
+{
+}
+
+SingleFlight::FlightPtr SingleFlight::acquire(const QString& key, bool& leader)
+{
+    QMutexLocker locker(&mutex);
+    auto it = inFlight.constFind(key);
+    if (it != inFlight.constEnd()) {
+        leader = false;
+        ++coalesced;
+        return it.value();
+    }
+
+    leader = true;
+    ++executed;
+    FlightPtr flight = std::make_shared<Flight>();
+    inFlight.insert(key, flight);
+    return flight;
+}
+
+void SingleFlight::complete(const QString& key, const FlightPtr& flight, const QString& result)
+{
+    finish(key, flight, &result);
+}
+
+void SingleFlight::abandon(const QString& key, const FlightPtr& flight)
+{
+    finish(key, flight, nullptr);
+}
+
+void SingleFlight::finish(const QString& key, const FlightPtr& flight, const QString* result)
+{
+    QMutexLocker locker(&mutex);
+    if (result) {
+        flight->result = *result;
+        flight->succeeded = true;
+    }
+    flight->done = true;
+
+    // 结束后移除，之后到达的同键请求重新执行
+    auto it = inFlight.find(key);
+    if (it != inFlight.end() && it.value() == flight) {
+        inFlight.erase(it);
+    }
+    finished.wakeAll();
+}
+
+bool SingleFlight::wait(const FlightPtr& flight, QString& result)
+{
+    QMutexLocker locker(&mutex);
+    while (!flight->done) {
+        finished.wait(&mutex);
+    }
+
+    if (!flight->succeeded) {
+        return false;
+    }
+    result = flight->result;
+    return true;
+}
+
+quint64 SingleFlight::executedCount() const
+{
+    QMutexLocker locker(&mutex);
+    return executed;
+}
+
+quint64 SingleFlight::coalescedCount() const
+{
+    QMutexLocker locker(&mutex);
+    return coalesced;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+
+// 相同键的并发请求只执行一次：第一个到达者负责执行并提交结果，
+// 其余调用方挂在同一个进行中的请求上等待结果
+class SingleFlight
+{
+public:
+    struct Flight;
+    using FlightPtr = std::shared_ptr<Flight>;
+
+    SingleFlight();
+
+    // leader为true时调用方必须随后调用complete或abandon
+    FlightPtr acquire(const QString& key, bool& leader);
+    void complete(const QString& key, const FlightPtr& flight, const QString& result);
+    void abandon(const QString& key, const FlightPtr& flight);
+    // 等待其他调用方的结果；对方放弃时返回false，调用方需自行执行
+    bool wait(const FlightPtr& flight, QString& result);
+
+    // 实际执行的请求数与被合并（节省）的请求数
+    quint64 executedCount() const;
+    quint64 coalescedCount() const;
+
+private:
+    void finish(const QString& key, const FlightPtr& flight, const QString* result);
+
+    mutable QMutex mutex;
+    QWaitCondition finished;
+    QHash<QString, FlightPtr> inFlight;
+    quint64 executed;
+    quint64 coalesced;
+};
+
+#endif
\ No newline at end of file
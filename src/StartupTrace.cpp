@@ -0,0 +1,141 @@
+﻿#include "StartupTrace.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+
+StartupTrace::Scope::Scope(const QString& name)
+    : name(name)
+    , startNs(StartupTrace::instance().elapsedNs())
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    StartupTrace& trace = StartupTrace::instance();
+    trace.record(name, startNs, trace.elapsedNs() - startNs);
+}
+
+StartupTrace& StartupTrace::instance()
+{
+    // 第一次调用时开始计时，main的第一行即调用
+    static StartupTrace trace;
+    return trace;
+}
+
+StartupTrace::StartupTrace()
+    : interactiveNs(0)
+    , enabled(false)
+    , interactive(false)
+    , ready(false)
+    , finished(false)
+{
+    clock.start();
+}
+
+void StartupTrace::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&mutex);
+    this->enabled = enabled;
+}
+
+bool StartupTrace::isEnabled() const
+{
+    QMutexLocker locker(&mutex);
+    return enabled;
+}
+
+qint64 StartupTrace::elapsedNs() const
+{
+    return clock.nsecsElapsed();
+}
+
+void StartupTrace::record(const QString& name, qint64 startNs, qint64 durationNs)
+{
+    // QApplication创建之前的阶段都在主线程上
+    const QCoreApplication* app = QCoreApplication::instance();
+    Phase phase;
+    phase.name = name;
+    phase.startNs = startNs;
+    phase.durationNs = durationNs;
+    phase.background = app && QThread::currentThread() != app->thread();
+
+    QMutexLocker locker(&mutex);
+    if (!finished) {
+        recorded.append(phase);
+    }
+}
+
+void StartupTrace::mark(const QString& name)
+{
+    record(name, elapsedNs(), 0);
+}
+
+void StartupTrace::markInteractive()
+{
+    const qint64 now = elapsedNs();
+    record("窗口可交互", now, 0);
+    {
+        QMutexLocker locker(&mutex);
+        interactive = true;
+        interactiveNs = now;
+    }
+    finishIfDone();
+}
+
+void StartupTrace::markReady()
+{
+    mark("后台预热完成");
+    {
+        QMutexLocker locker(&mutex);
+        ready = true;
+    }
+    finishIfDone();
+}
+
+QVector<StartupTrace::Phase> StartupTrace::phases() const
+{
+    QMutexLocker locker(&mutex);
+    QVector<Phase> sorted = recorded;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Phase& a, const Phase& b) {
+        return a.startNs < b.startNs;
+    });
+    return sorted;
+}
+
+QString StartupTrace::formatReport() const
+{
+    QString report = QString("%1  %2  %3\n")
+        .arg("开始(ms)", 9).arg("耗时(ms)", 9).arg("阶段");
+    for (const Phase& phase : phases()) {
+        report += QString("%1  %2  %3%4\n")
+            .arg(phase.startNs / 1.0e6, 9, 'f', 1)
+            .arg(phase.durationNs > 0 ? QString::number(phase.durationNs / 1.0e6, 'f', 1) : QString("-"), 9)
+            .arg(phase.name)
+            .arg(phase.background ? " [后台]" : "");
+    }
+    return report;
+}
+
+void StartupTrace::finishIfDone()
+{
+    bool print = false;
+    qint64 interactiveMs = 0;
+    {
+        QMutexLocker locker(&mutex);
+        if (finished || !interactive || !ready) {
+            return;
+        }
+        finished = true;
+        print = enabled;
+        interactiveMs = interactiveNs / 1000000;
+    }
+
+    if (print) {
+        qInfo().noquote() << "启动计时:\n" + formatReport();
+    }
+    if (interactiveMs > kInteractiveBudgetMs) {
+        qWarning() << "启动超出预算: 窗口可交互用时" << interactiveMs << "ms，预算"
+                   << kInteractiveBudgetMs << "ms";
+    }
+}
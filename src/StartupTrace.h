@@ -0,0 +1,66 @@
+﻿#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+
+// 启动计时：记录各初始化阶段（包括后台线程上的预热）相对进程启动的起止时间。
+// 窗口可交互且后台预热完成后结束；以 --startup-trace 启动时输出各阶段耗时，
+// 窗口可交互的时间超出预算时总是给出警告
+class StartupTrace
+{
+public:
+    struct Phase {
+        QString name;
+        qint64 startNs = 0;
+        qint64 durationNs = 0;  // 时间点为0
+        bool background = false;
+    };
+
+    // 作用域内的耗时记为一个阶段，可在任意线程使用
+    class Scope
+    {
+    public:
+        explicit Scope(const QString& name);
+        ~Scope();
+
+    private:
+        QString name;
+        qint64 startNs;
+    };
+
+    // 窗口从进程启动到可交互的预算
+    static const qint64 kInteractiveBudgetMs = 300;
+
+    static StartupTrace& instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    qint64 elapsedNs() const;
+
+    void record(const QString& name, qint64 startNs, qint64 durationNs);
+    void mark(const QString& name);
+    // 两者都到达后输出报告，只输出一次
+    void markInteractive();
+    void markReady();
+
+    QVector<Phase> phases() const;
+    QString formatReport() const;
+
+private:
+    StartupTrace();
+    void finishIfDone();
+
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QVector<Phase> recorded;
+    qint64 interactiveNs;
+    bool enabled;
+    bool interactive;
+    bool ready;
+    bool finished;
+};
+
+#endif
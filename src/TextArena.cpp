@@ -0,0 +1,94 @@
+﻿#include "TextArena.h"
+#include <cstring>
+
+TextArena::TextArena(qsizetype blockChars)
+    : blockChars(blockChars)
+    , allocated(0)
+{
+}
+
+bool TextArena::fits(qsizetype length) const
+{
+    if (blocks.empty()) {
+        return false;
+    }
+    const Block& current = blocks.back();
+    return current.capacity - current.used >= length;
+}
+
+qint64 TextArena::blockBytesFor(qsizetype length) const
+{
+    // 超长文本单独占用一个块
+    return qint64(qMax(blockChars, length)) * qint64(sizeof(char16_t));
+}
+
+void TextArena::addBlock(qsizetype length)
+{
+    Block block;
+    block.capacity = qMax(blockChars, length);
+    block.data.reset(new char16_t[block.capacity]);
+    allocated += block.capacity * qint64(sizeof(char16_t));
+    blocks.push_back(std::move(block));
+}
+
+TextArena::Ref TextArena::append(QStringView text)
+{
+    if (!fits(text.size())) {
+        addBlock(text.size());
+    }
+
+    Block& current = blocks.back();
+    Ref ref;
+    ref.block = int(blocks.size()) - 1;
+    ref.offset = current.used;
+    ref.length = text.size();
+
+    if (!text.isEmpty()) {
+        std::memcpy(current.data.get() + current.used, text.utf16(), text.size() * sizeof(char16_t));
+    }
+    current.used += text.size();
+    ++current.live;
+    return ref;
+}
+
+QStringView TextArena::view(const Ref& ref) const
+{
+    if (!ref.isValid() || ref.block >= int(blocks.size())) {
+        return QStringView();
+    }
+    const Block& block = blocks[ref.block];
+    if (!block.data) {
+        return QStringView();
+    }
+    return QStringView(block.data.get() + ref.offset, ref.length);
+}
+
+qint64 TextArena::release(const Ref& ref)
+{
+    if (!ref.isValid() || ref.block >= int(blocks.size())) {
+        return 0;
+    }
+
+    Block& block = blocks[ref.block];
+    if (!block.data || --block.live > 0) {
+        return 0;
+    }
+
+    qint64 bytes = block.capacity * qint64(sizeof(char16_t));
+    block.data.reset();
+    block.capacity = 0;
+    block.used = 0;
+    allocated -= bytes;
+    return bytes;
+}
+
+void TextArena::clear()
+{
+    blocks.clear();
+    allocated = 0;
+}
+
+qint64 TextArena::allocatedBytes() const
+{
+    return allocated;
+}
\ No newline at end of file
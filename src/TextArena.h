@@ -0,0 +1,56 @@
+﻿#ifndef TEXTARENA_H
+#define TEXTARENA_H
+
+#include <QString>
+#include <QStringView>
+#include <memory>
+#include <vector>
+
+// 文本片段在缓冲区中的位置
+struct TextSpan {
+    qsizetype offset;
+    qsizetype length;
+};
+
+// 追加式文本分配器：译文依次拷贝进固定大小的块中，不为每个分段单独分配QString
+// 本类不加锁，由调用方（SegmentStore）保证互斥
+class TextArena
+{
+public:
+    struct Ref {
+        int block = -1;
+        qsizetype offset = 0;
+        qsizetype length = 0;
+
+        bool isValid() const { return block >= 0; }
+    };
+
+    explicit TextArena(qsizetype blockChars = 256 * 1024);
+
+    // 当前块放不下时需要先调用addBlock，返回新块所需的字节数（用于预算申请）
+    bool fits(qsizetype length) const;
+    qint64 blockBytesFor(qsizetype length) const;
+    void addBlock(qsizetype length);
+
+    Ref append(QStringView text);
+    QStringView view(const Ref& ref) const;
+    // 释放一个片段；所在块的片段全部释放后回收该块，返回回收的字节数
+    qint64 release(const Ref& ref);
+
+    void clear();
+    qint64 allocatedBytes() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char16_t[]> data;
+        qsizetype capacity = 0;
+        qsizetype used = 0;
+        int live = 0;
+    };
+
+    qsizetype blockChars;
+    std::vector<Block> blocks;
+    qint64 allocated;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+﻿#include "TranslationBackend.h"
+#include <QThread>
+#include <cmath>
+
+MockBackend::MockBackend(const Config& config)
+    : config(config)
+    , random(config.seed)
+    , tokens(config.rateLimitPerSecond)
+    , lastRefillNs(0)
+{
+    clock.start();
+}
+
+bool MockBackend::translate(const QStringList& texts, const TranslationOptions& options,
+    QStringList& results, QString& error)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    waitForRateLimit();
+
+    qsizetype chars = 0;
+    for (const QString& text : texts) {
+        chars += text.length();
+    }
+
+    // 模拟网络请求的延迟
+    const double latencyMs = sampleLatencyMs(chars);
+    QThread::usleep(static_cast<unsigned long>(latencyMs * 1000.0));
+
+    const bool failed = sampleFailure();
+    {
+        QMutexLocker locker(&mutex);
+        ++counters.calls;
+        counters.segments += texts.size();
+        if (failed) {
+            ++counters.failures;
+        }
+        latencySamples.append(elapsed.nsecsElapsed() / 1.0e6);
+    }
+
+    if (failed) {
+        error = "模拟后端错误 (HTTP 503)";
+        return false;
+    }
+
+    results.clear();
+    results.reserve(texts.size());
+    for (const QString& text : texts) {
+        results << mockTranslate(text, options);
+    }
+    return true;
+}
+
+QString MockBackend::mockTranslate(QStringView text, const TranslationOptions& options)
+{
+    // 模拟翻译结果
+    QString translatedText;
+
+    // 简单的模拟翻译规则
+    if (options.sourceLang == "en" && options.targetLang == "zh") {
+        // 这里可以添加一些简单的英译中规则
+        translatedText = "【翻译结果】";
+    }
+    else if (options.sourceLang == "zh" && options.targetLang == "en") {
+        translatedText = "【Translation】";
+    }
+    else {
+        translatedText = "【Translated】";
+    }
+    translatedText += text;
+    return translatedText;
+}
+
+MockBackend::Stats MockBackend::stats() const
+{
+    QMutexLocker locker(&mutex);
+    return counters;
+}
+
+QVector<double> MockBackend::takeLatencySamples()
+{
+    QMutexLocker locker(&mutex);
+    QVector<double> samples;
+    samples.swap(latencySamples);
+    return samples;
+}
+
+double MockBackend::sampleLatencyMs(qsizetype chars)
+{
+    QMutexLocker locker(&mutex);
+    const double base = config.baseLatencyMs;
+    const double jitter = config.jitterMs;
+    double latency = base;
+    // 没有抖动时按固定延迟处理：标准差必须为正，std::normal_distribution不接受0
+    const LatencyModel model = jitter > 0 ? config.latencyModel : LatencyModel::Fixed;
+
+    switch (model) {
+    case LatencyModel::Fixed:
+        break;
+    case LatencyModel::Uniform:
+        latency = std::uniform_real_distribution<double>(base - jitter, base + jitter)(random);
+        break;
+    case LatencyModel::Normal:
+        latency = std::normal_distribution<double>(base, jitter)(random);
+        break;
+    case LatencyModel::LogNormal:
+        if (base > 0) {
+            latency = base * std::exp(std::normal_distribution<double>(0.0, jitter / base)(random));
+        }
+        break;
+    }
+
+    latency += chars * config.perCharLatencyUs / 1000.0;
+    return std::max(latency, 0.0);
+}
+
+bool MockBackend::sampleFailure()
+{
+    if (config.errorRate <= 0.0) {
+        return false;
+    }
+    QMutexLocker locker(&mutex);
+    return std::bernoulli_distribution(std::min(config.errorRate, 1.0))(random);
+}
+
+void MockBackend::waitForRateLimit()
+{
+    if (config.rateLimitPerSecond <= 0) {
+        return;
+    }
+
+    bool throttled = false;
+    while (true) {
+        qint64 waitUs = 0;
+        {
+            QMutexLocker locker(&mutex);
+            const qint64 now = clock.nsecsElapsed();
+            tokens = std::min<double>(config.rateLimitPerSecond,
+                tokens + (now - lastRefillNs) * config.rateLimitPerSecond / 1.0e9);
+            lastRefillNs = now;
+
+            if (tokens >= 1.0) {
+                tokens -= 1.0;
+                if (throttled) {
+                    ++counters.throttled;
+                }
+                return;
+            }
+            waitUs = static_cast<qint64>((1.0 - tokens) * 1.0e6 / config.rateLimitPerSecond) + 1;
+        }
+
+        // 相当于收到429后按Retry-After等待
+        throttled = true;
+        QThread::usleep(static_cast<unsigned long>(waitUs));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+﻿#ifndef TRANSLATIONBACKEND_H
+#define TRANSLATIONBACKEND_H
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <random>
+
+// 支持的专业领域
+enum class Domain {
+    General,
+    Medical,
+    Legal,
+    Technical,
+    Academic,
+    Business
+};
+
+// 一次翻译任务开始时的设置快照，工作线程只读取快照
+struct TranslationOptions {
+    QString sourceLang;
+    QString targetLang;
+    Domain domain;
+};
+
+// 翻译后端：一次调用翻译一批分段，返回未经术语和后处理的译文
+// 实现必须是线程安全的，引擎会从多个工作线程并发调用
+class TranslationBackend
+{
+public:
+    virtual ~TranslationBackend() = default;
+
+    virtual bool translate(const QStringList& texts, const TranslationOptions& options,
+        QStringList& results, QString& error) = 0;
+    // 启动时在后台线程调用，用于提前建立连接等；默认无需预热
+    virtual void warmUp() {}
+};
+
+// 可配置的模拟后端：延迟分布、抖动、错误率和速率限制
+class MockBackend : public TranslationBackend
+{
+public:
+    enum class LatencyModel {
+        Fixed,      // 固定为baseLatencyMs
+        Uniform,    // baseLatencyMs ± jitterMs
+        Normal,     // 均值baseLatencyMs，标准差jitterMs
+        LogNormal   // 中位数baseLatencyMs，长尾由jitterMs/baseLatencyMs决定
+    };
+
+    struct Config {
+        LatencyModel latencyModel = LatencyModel::Fixed;
+        int baseLatencyMs = 100;
+        int jitterMs = 0;
+        // 按请求字符数增加的处理时间
+        double perCharLatencyUs = 0.0;
+        double errorRate = 0.0;
+        // 每秒允许的请求数，0表示不限制；超出时等待令牌
+        int rateLimitPerSecond = 0;
+        quint32 seed = 1;
+    };
+
+    struct Stats {
+        quint64 calls = 0;
+        quint64 segments = 0;
+        quint64 failures = 0;
+        quint64 throttled = 0;
+    };
+
+    explicit MockBackend(const Config& config = Config());
+
+    bool translate(const QStringList& texts, const TranslationOptions& options,
+        QStringList& results, QString& error) override;
+
+    Stats stats() const;
+    // 取出并清空每次调用的耗时（毫秒，含限流等待）
+    QVector<double> takeLatencySamples();
+
+    static QString mockTranslate(QStringView text, const TranslationOptions& options);
+
+private:
+    double sampleLatencyMs(qsizetype chars);
+    bool sampleFailure();
+    void waitForRateLimit();
+
+    Config config;
+    mutable QMutex mutex;
+    std::mt19937 random;
+    Stats counters;
+    QVector<double> latencySamples;
+
+    // 令牌桶
+    QElapsedTimer clock;
+    double tokens;
+    qint64 lastRefillNs;
+};
+
+#endif
\ No newline at end of file
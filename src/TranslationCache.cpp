@@ -0,0 +1,74 @@
+﻿#include "TranslationCache.h"
+#include "MemoryBudget.h"
+
+TranslationCache::TranslationCache(qint64 maxBytes)
+    : entries(maxBytes)
+    , accountedBytes(0)
+    , hits(0)
+{
+    MemoryBudget::instance().setReclaimer(this, [this](qint64 bytes) {
+        shrink(bytes);
+    });
+}
+
+TranslationCache::~TranslationCache()
+{
+    MemoryBudget::instance().removeReclaimer(this);
+    MemoryBudget::instance().releaseAll(this);
+}
+
+bool TranslationCache::lookup(const QString& key, QString& value)
+{
+    QMutexLocker locker(&mutex);
+    const QString* cached = entries.object(key);
+    if (!cached) {
+        return false;
+    }
+    ++hits;
+    value = *cached;
+    return true;
+}
+
+void TranslationCache::insert(const QString& key, const QString& value)
+{
+    const qint64 cost = (key.size() + value.size()) * qint64(sizeof(QChar));
+
+    QMutexLocker locker(&mutex);
+    entries.insert(key, new QString(value), cost);
+    syncBudget();
+}
+
+void TranslationCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    syncBudget();
+}
+
+quint64 TranslationCache::hitCount() const
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+void TranslationCache::shrink(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    // 暂时降低容量让QCache按最近使用淘汰，再恢复原容量
+    const qsizetype capacity = entries.maxCost();
+    entries.setMaxCost(qMax<qsizetype>(0, entries.totalCost() - bytes));
+    entries.setMaxCost(capacity);
+    syncBudget();
+}
+
+void TranslationCache::syncBudget()
+{
+    const qint64 total = entries.totalCost();
+    if (total > accountedBytes) {
+        MemoryBudget::instance().charge(this, total - accountedBytes);
+    }
+    else if (total < accountedBytes) {
+        MemoryBudget::instance().release(this, accountedBytes - total);
+    }
+    accountedBytes = total;
+}
\ No newline at end of file
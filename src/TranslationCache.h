@@ -0,0 +1,34 @@
+﻿#ifndef TRANSLATIONCACHE_H
+#define TRANSLATIONCACHE_H
+
+#include <QString>
+#include <QCache>
+#include <QMutex>
+
+// 分段译文缓存：键为（语言对，领域，原文），按最近使用淘汰；
+// 占用计入进程内存预算，但写入时不等待预算；预算紧张时由申请方要求收缩
+class TranslationCache
+{
+public:
+    explicit TranslationCache(qint64 maxBytes = 64 * 1024 * 1024);
+    ~TranslationCache();
+
+    bool lookup(const QString& key, QString& value);
+    void insert(const QString& key, const QString& value);
+    void clear();
+
+    quint64 hitCount() const;
+
+private:
+    // 淘汰最久未用的条目，释放至少bytes字节
+    void shrink(qint64 bytes);
+    // 把QCache当前的总占用同步到内存预算
+    void syncBudget();
+
+    mutable QMutex mutex;
+    QCache<QString, QString> entries;
+    qint64 accountedBytes;
+    quint64 hits;
+};
+
+#endif
\ No newline at end of file
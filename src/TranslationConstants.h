@@ -0,0 +1,25 @@
+﻿#ifndef TRANSLATIONCONSTANTS_H
+#define TRANSLATIONCONSTANTS_H
+
+// 文档翻译的公共参数，引擎和任务队列共用
+namespace TranslationConstants {
+    // 文档模式下单个分段的最大长度，对应分段对照视图中的一行
+    const int kSegmentMaxLength = 500;
+    // 单次请求可合并的最大字符数，与splitText的默认值一致
+    const int kMaxRequestLength = 4000;
+    // 后端请求失败时的最大尝试次数
+    const int kMaxBackendAttempts = 3;
+    // 重试前的退避：第n次重试约等待kBackoffBaseMs * 2^(n-1)，加随机抖动，不超过kBackoffMaxMs
+    const int kBackoffBaseMs = 200;
+    const int kBackoffMaxMs = 2000;
+    // 翻译请求以等待网络为主，线程数不少于此值
+    const int kMinWorkerThreads = 8;
+    // 界面文档和任务队列的工作单元优先级
+    const int kDocumentPriority = 0;
+    // 预翻译排在界面发起的任务之后，且最多占用一半线程
+    const int kSpeculativePriority = -1;
+    // 输出文件中分段之间的分隔符，与SegmentStore::joinedTarget一致
+    const char* const kSegmentSeparator = " ";
+}
+
+#endif
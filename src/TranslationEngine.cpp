@@ -1,17 +1,98 @@
 ﻿#include "TranslationEngine.h"
+#include "OrderedFileWriter.h"
+#include "SegmentScheduler.h"
+#include "StartupTrace.h"
+#include "TranslationConstants.h"
+#include <QHash>
+#include <QRandomGenerator>
+
+using namespace TranslationConstants;
+
+// 一次文档翻译任务：原文处理结果由所有目标语言共享，工作单元为（语言，请求）
+struct TranslationEngine::DocumentJob {
+    // 译文写入的分段存储；外部任务的存储由任务自己持有
+    SegmentStore* store = nullptr;
+    std::shared_ptr<SegmentStore> ownedStore;
+    // 开始时的原文快照：加载新文档后，进行中的请求仍读取旧原文
+    QString source;
+    QVector<TextSpan> spans;
+    quint64 generation = 0;
+    QVector<TranslationOptions> tracks;
+    QVector<std::shared_ptr<OrderedFileWriter>> writers;
+    // 去重后的分段序号，以及每个分段的重复出现位置
+    QVector<int> uniqueIndices;
+    QHash<int, QVector<int>> duplicates;
+    // 第i个请求覆盖uniqueIndices[requestStarts[i], requestStarts[i + 1])
+    QVector<int> requestStarts;
+    std::unique_ptr<SegmentScheduler> scheduler;
+    int totalUnits = 0;
+    std::atomic_int remainingUnits{ 0 };
+    std::atomic_bool failed{ false };
+    // 预翻译只填充缓存，不写入分段存储和输出文件
+    bool speculative = false;
+    // 外部任务不发出引擎的信号，错误记录在error中
+    bool external = false;
+    QMutex errorMutex;
+    QString error;
+    // 被取消或被新的任务取代；工作线程不再领取新单元，等待预算的写入立即返回
+    std::atomic_bool abandoned{ false };
+
+    QStringView sourceView(int index) const
+    {
+        const TextSpan& span = spans.at(index);
+        return QStringView(source).mid(span.offset, span.length);
+    }
+};
 
 TranslationEngine::TranslationEngine(QObject* parent)
     : QObject(parent)
     , sourceLang("en")
     , targetLang("zh")
     , currentDomain(Domain::General)
+    , translationBackend(std::make_shared<MockBackend>())
+    , segments(new SegmentStore(this))
+    , priorityFirst(-1)
+    , priorityLast(-1)
+    , terminologyLoaded(false)
+    , pendingWarmUps(0)
 {
-    loadTerminology();
+    workerPool.setMaxThreadCount(qMax(QThread::idealThreadCount(), kMinWorkerThreads));
 }
 
 TranslationEngine::~TranslationEngine()
 {
-    // 清理资源
+    // 等待后台翻译和预热结束后再释放资源
+    cancelTranslation();
+    cancelSpeculativeTranslation();
+    workerPool.waitForDone();
+    warmUpPool.waitForDone();
+}
+
+void TranslationEngine::warmUp()
+{
+    // 词典和后端互不依赖，各占一个线程并行预热
+    pendingWarmUps = 2;
+    warmUpPool.start([this]() {
+        {
+            StartupTrace::Scope scope("加载术语词典");
+            ensureTerminology();
+        }
+        finishWarmUp();
+    });
+    warmUpPool.start([this]() {
+        {
+            StartupTrace::Scope scope("预热翻译后端");
+            currentBackend()->warmUp();
+        }
+        finishWarmUp();
+    });
+}
+
+void TranslationEngine::finishWarmUp()
+{
+    if (--pendingWarmUps == 0) {
+        emit ready();
+    }
 }
 
 void TranslationEngine::setApiKey(const QString& key)
@@ -38,6 +119,209 @@ void TranslationEngine::setTargetLanguage(const QString& lang)
     targetLang = lang;
 }
 
+SegmentStore* TranslationEngine::segmentStore() const
+{
+    return segments;
+}
+
+void TranslationEngine::loadDocument(QString text)
+{
+    // 进行中的任务持有旧原文的快照，只需取消，不必等待它们退出
+    cancelTranslation();
+    cancelSpeculativeTranslation();
+
+    // 分段只记录位置，原文整体移入存储，不再逐段拷贝
+    QVector<TextSpan> spans = splitSpans(text, kSegmentMaxLength);
+    segments->setSource(std::move(text), std::move(spans));
+}
+
+TranslationOptions TranslationEngine::currentOptions()
+{
+    QMutexLocker locker(&translationMutex);
+    return { sourceLang, targetLang, currentDomain };
+}
+
+void TranslationEngine::setBackend(std::shared_ptr<TranslationBackend> backend)
+{
+    QMutexLocker locker(&translationMutex);
+    translationBackend = std::move(backend);
+}
+
+std::shared_ptr<TranslationBackend> TranslationEngine::currentBackend()
+{
+    QMutexLocker locker(&translationMutex);
+    return translationBackend;
+}
+
+void TranslationEngine::setMaxConcurrency(int threads)
+{
+    workerPool.setMaxThreadCount(qMax(threads, 1));
+}
+
+QStringList TranslationEngine::translateSegments(const QStringList& texts,
+    const TranslationOptions& options, QString* error)
+{
+    QList<QStringView> views;
+    views.reserve(texts.size());
+    for (const QString& text : texts) {
+        views << QStringView(text);
+    }
+
+    QStringList results;
+    QString message;
+    if (!dispatchSegments(views, options, results, message)) {
+        if (error) {
+            *error = message;
+        }
+        return QStringList();
+    }
+    return results;
+}
+
+quint64 TranslationEngine::dispatchedSegmentCount() const
+{
+    return inFlightSegments.executedCount();
+}
+
+quint64 TranslationEngine::coalescedSegmentCount() const
+{
+    return inFlightSegments.coalescedCount();
+}
+
+quint64 TranslationEngine::cachedSegmentCount() const
+{
+    return resultCache.hitCount();
+}
+
+bool TranslationEngine::dispatchSegments(const QList<QStringView>& texts,
+    const TranslationOptions& options, QStringList& results, QString& error,
+    const std::atomic_bool* cancelled)
+{
+    // 相同（分段，语言对，领域）的并发请求挂到同一个进行中的请求上
+    const QString optionsKey = QString("%1\x1f%2\x1f%3\x1f").arg(options.sourceLang, options.targetLang)
+        .arg(static_cast<int>(options.domain));
+
+    QStringList keys;
+    QVector<SingleFlight::FlightPtr> flights(texts.size());
+    QVector<int> leaders;
+    QVector<bool> isLeader(texts.size(), false);
+    QStringList leaderTexts;
+    keys.reserve(texts.size());
+    results = QStringList(texts.size());
+    for (int i = 0; i < texts.size(); ++i) {
+        QString key = optionsKey;
+        key += texts.at(i);
+        keys << key;
+
+        // 已翻译过（包括预翻译）的分段直接取缓存
+        if (resultCache.lookup(key, results[i])) {
+            continue;
+        }
+        bool leader = false;
+        flights[i] = inFlightSegments.acquire(key, leader);
+        if (leader) {
+            leaders << i;
+            isLeader[i] = true;
+            leaderTexts << texts.at(i).toString();
+        }
+    }
+
+    // 只把由本调用负责的分段发往后端，完成后先提交结果再等待其他调用方
+    bool succeeded = true;
+    if (!leaders.isEmpty()) {
+        QStringList translated;
+        succeeded = performBackendRequest(leaderTexts, options, translated, error, cancelled);
+        for (int j = 0; j < leaders.size(); ++j) {
+            const int i = leaders.at(j);
+            if (succeeded) {
+                results[i] = translated.at(j);
+                resultCache.insert(keys.at(i), results.at(i));
+                inFlightSegments.complete(keys.at(i), flights.at(i), results.at(i));
+            }
+            else {
+                // 等待者会自行重新请求
+                inFlightSegments.abandon(keys.at(i), flights.at(i));
+            }
+        }
+    }
+
+    for (int i = 0; i < texts.size() && succeeded; ++i) {
+        if (!flights.at(i) || isLeader.at(i) || inFlightSegments.wait(flights.at(i), results[i])) {
+            continue;
+        }
+        QStringList translated;
+        succeeded = performBackendRequest({ texts.at(i).toString() }, options, translated, error,
+            cancelled);
+        if (succeeded) {
+            results[i] = translated.at(0);
+            resultCache.insert(keys.at(i), results.at(i));
+        }
+    }
+    return succeeded;
+}
+
+bool TranslationEngine::performBackendRequest(const QStringList& texts,
+    const TranslationOptions& options, QStringList& results, QString& error,
+    const std::atomic_bool* cancelled)
+{
+    // 术语、数字、URL和代码以占位符发送，译文返回后再还原
+    const PlaceholderMasker& masker = maskerFor(options.domain);
+    QStringList maskedTexts;
+    QVector<QStringList> replacements;
+    maskedTexts.reserve(texts.size());
+    replacements.reserve(texts.size());
+    for (const QString& text : texts) {
+        PlaceholderMasker::Masked masked = masker.mask(text);
+        maskedTexts << std::move(masked.text);
+        replacements.append(std::move(masked.replacements));
+    }
+
+    const std::shared_ptr<TranslationBackend> backend = currentBackend();
+    for (int attempt = 0; attempt < kMaxBackendAttempts; ++attempt) {
+        if (attempt > 0 && !waitBeforeRetry(attempt, cancelled)) {
+            error = "翻译已取消";
+            return false;
+        }
+        if (!backend->translate(maskedTexts, options, results, error)) {
+            continue;
+        }
+        if (results.size() != texts.size()) {
+            error = "翻译后端返回的结果数量不匹配";
+            continue;
+        }
+
+        bool restored = true;
+        for (int i = 0; i < results.size() && restored; ++i) {
+            // 后处理在还原前进行，不会改动URL和代码中的空白
+            results[i] = postProcessTranslation(results.at(i));
+            restored = PlaceholderMasker::restore(results[i], replacements.at(i));
+        }
+        if (restored) {
+            return true;
+        }
+        error = "译文中缺少占位符";
+    }
+    return false;
+}
+
+bool TranslationEngine::waitBeforeRetry(int attempt, const std::atomic_bool* cancelled)
+{
+    // 指数退避加随机抖动，限流或暂时不可用的后端不会被立即重试的请求继续压垮，
+    // 多个线程的重试也不会同时到达
+    const int ceiling = qMin(kBackoffBaseMs << (attempt - 1), kBackoffMaxMs);
+    const int delayMs = ceiling / 2 + QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+
+    // 分段睡眠，等待期间被取消时立即返回
+    const int sliceMs = 20;
+    for (int waited = 0; waited < delayMs; waited += sliceMs) {
+        if (cancelled && *cancelled) {
+            return false;
+        }
+        QThread::msleep(static_cast<unsigned long>(qMin(sliceMs, delayMs - waited)));
+    }
+    return !(cancelled && *cancelled);
+}
+
 void TranslationEngine::translateText(const QString& text)
 {
     if (text.isEmpty()) {
@@ -66,62 +350,417 @@ void TranslationEngine::translateBatch(const QStringList& texts)
 {
     QStringList translatedTexts;
     int completed = 0;
+    const TranslationOptions options = currentOptions();
 
     for (const QString& text : texts) {
-        // 使用模拟翻译
-        QString translated = performMockTranslationSync(text);
-        translatedTexts << translated;
+        QStringList translated;
+        QString error;
+        if (!dispatchSegments({ QStringView(text) }, options, translated, error)) {
+            emit errorOccurred(error);
+            return;
+        }
+        translatedTexts << translated.first();
         completed++;
 
         int progress = (completed * 100) / texts.size();
         emit translationProgress(progress);
-
-        // 短暂延迟以模拟网络请求
-        QThread::msleep(100);
     }
 
     emit batchTranslationFinished(translatedTexts);
 }
 
-void TranslationEngine::performSingleTranslation(const QString& text)
+bool TranslationEngine::canWriteDocument(QString* error) const
 {
-    // 使用模拟翻译
-    performMockTranslation(text);
+    QString reason;
+    const int total = segments->count();
+    if (total == 0) {
+        reason = "没有可保存的翻译内容";
+    }
+    for (int i = 0; i < total && reason.isEmpty(); ++i) {
+        // 翻译时已写入输出文件的译文被释放，不能再从内存保存
+        if (segments->isTargetReleased(i)) {
+            reason = "译文已在翻译过程中写入输出文件，内存中不再保留，请直接使用该输出文件";
+        }
+        else if (!segments->hasTarget(i)) {
+            reason = QString("第 %1 个分段没有译文（未翻译、已取消或翻译失败）").arg(i + 1);
+        }
+    }
+
+    if (error) {
+        *error = reason;
+    }
+    return reason.isEmpty();
 }
 
-void TranslationEngine::performMockTranslation(const QString& text)
+bool TranslationEngine::writeDocument(const QString& filePath, QString* error)
 {
-    // 模拟异步翻译过程
-    QTimer::singleShot(1000, [this, text]() {
-        QString translatedText = performMockTranslationSync(text);
-        emit translationFinished(translatedText);
-        });
+    if (!canWriteDocument(error)) {
+        return false;
+    }
+
+    const int total = segments->count();
+    OrderedFileWriter writer(filePath);
+    writer.setSeparator(kSegmentSeparator);
+    writer.setExpectedCount(total);
+    bool written = writer.open();
+    for (int i = 0; i < total && written; ++i) {
+        written = writer.write(i, segments->target(i));
+    }
+    if (written && writer.commit()) {
+        return true;
+    }
+
+    if (error) {
+        *error = writer.errorString();
+    }
+    return false;
 }
 
-QString TranslationEngine::performMockTranslationSync(const QString& text)
+void TranslationEngine::setPriorityRange(int first, int last)
 {
-    // 模拟翻译结果
-    QString translatedText = text;
+    priorityFirst = first;
+    priorityLast = last;
+}
 
-    // 简单的模拟翻译规则
-    if (sourceLang == "en" && targetLang == "zh") {
-        // 这里可以添加一些简单的英译中规则
-        translatedText = "【翻译结果】" + text;
+void TranslationEngine::translateDocument(const QString& outputPath)
+{
+    QStringList outputPaths;
+    if (!outputPath.isEmpty()) {
+        outputPaths << outputPath;
     }
-    else if (sourceLang == "zh" && targetLang == "en") {
-        translatedText = "【Translation】" + text;
+    translateDocuments({ currentOptions().targetLang }, outputPaths);
+}
+
+void TranslationEngine::translateDocuments(const QStringList& targetLangs,
+    const QStringList& outputPaths)
+{
+    if (segments->count() == 0 || targetLangs.isEmpty()) {
+        emit documentTranslationFinished();
+        return;
     }
-    else {
-        translatedText = "【Translated】" + text;
+
+    // 取消上一次文档翻译和预翻译，不等待其退出；预翻译已完成的分段留在缓存中。
+    // 清空译文会使代数加一，旧任务之后的写入被分段存储拒绝
+    cancelTranslation();
+    cancelSpeculativeTranslation();
+
+    segments->setTargetLanguages(targetLangs);
+
+    QVector<TranslationOptions> tracks;
+    const TranslationOptions options = currentOptions();
+    for (const QString& lang : targetLangs) {
+        tracks.append(TranslationOptions{ options.sourceLang, lang, options.domain });
+    }
+    std::shared_ptr<DocumentJob> job = planDocument(segments, tracks);
+
+    // 边翻译边写出；中途取消或出错时临时文件被丢弃
+    for (int track = 0; track < outputPaths.size() && track < targetLangs.size(); ++track) {
+        auto writer = std::make_shared<OrderedFileWriter>(outputPaths.at(track));
+        writer->setSeparator(kSegmentSeparator);
+        writer->setExpectedCount(segments->count());
+        if (!writer->open()) {
+            emit errorOccurred("无法写入文件: " + outputPaths.at(track));
+            return;
+        }
+        job->writers.append(writer);
+    }
+    documentJob = job;
+
+    // 工作线程从调度器领取单元：先处理可见分段，其余按请求轮流调度各语言
+    const int workers = qMin(workerPool.maxThreadCount(), job->totalUnits);
+    for (int i = 0; i < workers; ++i) {
+        workerPool.start([this, job]() {
+            runDocumentWorker(job);
+        }, kDocumentPriority);
     }
+}
 
-    // 应用术语替换
-    translatedText = applyTerminology(translatedText);
+void TranslationEngine::startSpeculativeTranslation()
+{
+    cancelSpeculativeTranslation();
+    if (segments->count() == 0) {
+        return;
+    }
 
-    // 后处理
-    translatedText = postProcessTranslation(translatedText);
+    std::shared_ptr<DocumentJob> job = planDocument(segments, { currentOptions() });
+    job->speculative = true;
+    speculativeJob = job;
 
-    return translatedText;
+    const int workers = qMin(qMax(workerPool.maxThreadCount() / 2, 1), job->totalUnits);
+    for (int i = 0; i < workers; ++i) {
+        workerPool.start([this, job]() {
+            runDocumentWorker(job);
+        }, kSpeculativePriority);
+    }
+}
+
+void TranslationEngine::cancelSpeculativeTranslation()
+{
+    // 已发出的请求继续完成并写入缓存，只是不再领取新的单元
+    if (speculativeJob) {
+        speculativeJob->abandoned = true;
+        speculativeJob.reset();
+    }
+}
+
+std::shared_ptr<TranslationEngine::DocumentJob> TranslationEngine::planDocument(
+    SegmentStore* store, const QVector<TranslationOptions>& tracks,
+    const OrderedFileWriter* resumeFrom)
+{
+    auto job = std::make_shared<DocumentJob>();
+    job->store = store;
+    job->tracks = tracks;
+
+    store->snapshotSource(job->source, job->spans, job->generation);
+
+    // 原文处理对所有语言共享：相同的分段只翻译一次；继续时跳过已写出的分段
+    const int total = job->spans.size();
+    QHash<QStringView, int> firstOccurrence;
+    for (int i = 0; i < total; ++i) {
+        if (resumeFrom && resumeFrom->isWritten(i)) {
+            continue;
+        }
+        QStringView source = job->sourceView(i);
+        auto it = firstOccurrence.constFind(source);
+        if (it != firstOccurrence.constEnd()) {
+            job->duplicates[it.value()].append(i);
+            continue;
+        }
+        firstOccurrence.insert(source, i);
+        job->uniqueIndices.append(i);
+    }
+
+    // 把连续的分段合并为一次请求，并记录每个分段由哪个请求翻译
+    QVector<int> requestOfSegment(total, 0);
+    qsizetype requestLength = 0;
+    for (int u = 0; u < job->uniqueIndices.size(); ++u) {
+        const int index = job->uniqueIndices.at(u);
+        qsizetype length = job->spans.at(index).length;
+        if (job->requestStarts.isEmpty() || requestLength + length > kMaxRequestLength) {
+            job->requestStarts.append(u);
+            requestLength = 0;
+        }
+        requestLength += length;
+
+        const int request = job->requestStarts.size() - 1;
+        requestOfSegment[index] = request;
+        for (int duplicate : job->duplicates.value(index)) {
+            requestOfSegment[duplicate] = request;
+        }
+    }
+    job->requestStarts.append(job->uniqueIndices.size());
+
+    const int requestCount = job->requestStarts.size() - 1;
+    job->totalUnits = requestCount * job->tracks.size();
+    job->remainingUnits = job->totalUnits;
+    job->scheduler = std::make_unique<SegmentScheduler>(std::move(requestOfSegment),
+        requestCount, job->tracks.size());
+    return job;
+}
+
+TranslationEngine::DocumentJobPtr TranslationEngine::prepareDocument(QString text,
+    const TranslationOptions& options, const std::shared_ptr<OrderedFileWriter>& writer)
+{
+    QVector<TextSpan> spans = splitSpans(text, kSegmentMaxLength);
+    auto store = std::make_shared<SegmentStore>();
+    store->setTargetLanguages({ options.targetLang });
+    store->setSource(std::move(text), std::move(spans));
+    writer->setExpectedCount(store->count());
+
+    DocumentJobPtr job = planDocument(store.get(), { options }, writer.get());
+    job->ownedStore = std::move(store);
+    job->writers.append(writer);
+    job->external = true;
+    return job;
+}
+
+bool TranslationEngine::runNextDocumentUnit(const DocumentJobPtr& job)
+{
+    int request = 0;
+    int track = 0;
+    if (job->failed || job->abandoned || !job->scheduler->take(-1, -1, request, track)) {
+        return false;
+    }
+    runDocumentRequest(job, track, request);
+    return true;
+}
+
+QString TranslationEngine::documentError(const DocumentJobPtr& job)
+{
+    QMutexLocker locker(&job->errorMutex);
+    return job->error;
+}
+
+void TranslationEngine::cancelDocument(const DocumentJobPtr& job)
+{
+    job->abandoned = true;
+}
+
+void TranslationEngine::startOnWorkerPool(std::function<void()> task, int priority)
+{
+    workerPool.start(std::move(task), priority);
+}
+
+int TranslationEngine::maxConcurrency() const
+{
+    return workerPool.maxThreadCount();
+}
+
+void TranslationEngine::failDocument(DocumentJob& job, const QString& error)
+{
+    // 先记录原因再设置标志，看到failed的线程总能读到原因
+    {
+        QMutexLocker locker(&job.errorMutex);
+        if (job.error.isEmpty()) {
+            job.error = error;
+        }
+    }
+    if (job.failed.exchange(true) || job.external || job.abandoned) {
+        return;
+    }
+    emit errorOccurred(error);
+}
+
+void TranslationEngine::cancelTranslation()
+{
+    // 已发出的请求继续完成，结果不再写入
+    if (documentJob) {
+        documentJob->abandoned = true;
+        documentJob.reset();
+    }
+}
+
+void TranslationEngine::runDocumentWorker(const std::shared_ptr<DocumentJob>& job)
+{
+    int request = 0;
+    int track = 0;
+    while (!job->failed && !job->abandoned
+        && job->scheduler->take(priorityFirst, priorityLast, request, track)) {
+        runDocumentRequest(job, track, request);
+    }
+}
+
+void TranslationEngine::runDocumentRequest(const std::shared_ptr<DocumentJob>& job,
+    int track, int request)
+{
+    if (!job->abandoned && !job->failed) {
+        const int begin = job->requestStarts.at(request);
+        const int end = job->requestStarts.at(request + 1);
+
+        QList<QStringView> sources;
+        sources.reserve(end - begin);
+        for (int u = begin; u < end; ++u) {
+            sources << job->sourceView(job->uniqueIndices.at(u));
+        }
+        QStringList translations;
+        QString error;
+        const bool ok = dispatchSegments(sources, job->tracks.at(track), translations, error,
+            &job->abandoned);
+        if (job->speculative) {
+            // 预翻译失败不打扰用户，正式翻译时会重新请求
+            if (!ok) {
+                job->failed = true;
+            }
+            return;
+        }
+        if (!ok) {
+            failDocument(*job, error);
+            finishDocumentUnit(job);
+            return;
+        }
+
+        for (int u = begin; u < end; ++u) {
+            const int index = job->uniqueIndices.at(u);
+            const QString& translated = translations.at(u - begin);
+            if (!storeDocumentTranslation(*job, track, index, translated)) {
+                break;
+            }
+
+            bool stored = true;
+            const QVector<int> duplicates = job->duplicates.value(index);
+            for (int duplicate : duplicates) {
+                if (!storeDocumentTranslation(*job, track, duplicate, translated)) {
+                    stored = false;
+                    break;
+                }
+            }
+            if (!stored) {
+                break;
+            }
+        }
+    }
+
+    finishDocumentUnit(job);
+}
+
+bool TranslationEngine::storeDocumentTranslation(DocumentJob& job, int track, int index,
+    const QString& translated)
+{
+    // 内存预算不足时在此等待，直到其他任务释放内存；无法继续时整个任务失败
+    QString error;
+    if (!job.store->setTarget(job.generation, track, index, translated, &job.abandoned, &error)) {
+        if (!error.isEmpty()) {
+            failDocument(job, error);
+        }
+        return false;
+    }
+
+    if (track < job.writers.size()) {
+        OrderedFileWriter* writer = job.writers.at(track).get();
+        if (!writer->write(index, translated)) {
+            failDocument(job, writer->errorString());
+            return false;
+        }
+        job.store->releaseTargetsBefore(job.generation, track, writer->nextIndex());
+    }
+    return true;
+}
+
+void TranslationEngine::finishDocumentUnit(const std::shared_ptr<DocumentJob>& job)
+{
+    if (job->speculative || job->external || job->abandoned) {
+        return;
+    }
+
+    const int completed = job->totalUnits - --job->remainingUnits;
+    const int progress = (completed * 100) / job->totalUnits;
+    if (progress != ((completed - 1) * 100) / job->totalUnits) {
+        emit translationProgress(progress);
+    }
+
+    if (completed != job->totalUnits || job->failed) {
+        return;
+    }
+
+    for (const auto& writer : job->writers) {
+        if (!writer->commit()) {
+            emit errorOccurred(writer->errorString());
+            return;
+        }
+    }
+
+    emit documentTranslationFinished();
+}
+
+void TranslationEngine::performSingleTranslation(const QString& text)
+{
+    // 使用模拟翻译
+    performMockTranslation(text);
+}
+
+void TranslationEngine::performMockTranslation(const QString& text)
+{
+    // 在工作线程中等待后端，完成后通过信号返回界面线程
+    const TranslationOptions options = currentOptions();
+    workerPool.start([this, text, options]() {
+        QStringList translated;
+        QString error;
+        if (!dispatchSegments({ QStringView(text) }, options, translated, error)) {
+            emit errorOccurred(error);
+            return;
+        }
+        emit translationFinished(translated.first());
+    });
 }
 
 QString TranslationEngine::parseTranslationResponse(const QByteArray& response)
@@ -133,17 +772,28 @@ QString TranslationEngine::parseTranslationResponse(const QByteArray& response)
 QStringList TranslationEngine::splitText(const QString& text, int maxLength)
 {
     QStringList chunks;
-    int start = 0;
+    const QVector<TextSpan> spans = splitSpans(text, maxLength);
+    chunks.reserve(spans.size());
+    for (const TextSpan& span : spans) {
+        chunks << text.mid(span.offset, span.length);
+    }
+    return chunks;
+}
+
+QVector<TextSpan> TranslationEngine::splitSpans(const QString& text, int maxLength)
+{
+    QVector<TextSpan> spans;
+    qsizetype start = 0;
 
     while (start < text.length()) {
-        int end = start + maxLength;
+        qsizetype end = start + maxLength;
         if (end >= text.length()) {
-            chunks << text.mid(start);
+            spans.append({ start, text.length() - start });
             break;
         }
 
         // 尽量在句子边界分割
-        int splitPos = text.lastIndexOf('.', end);
+        qsizetype splitPos = text.lastIndexOf('.', end);
         if (splitPos == -1 || splitPos < start) {
             splitPos = text.lastIndexOf(' ', end);
         }
@@ -151,17 +801,30 @@ QStringList TranslationEngine::splitText(const QString& text, int maxLength)
             splitPos = end;
         }
 
-        chunks << text.mid(start, splitPos - start + 1);
+        spans.append({ start, splitPos - start + 1 });
         start = splitPos + 1;
     }
 
-    return chunks;
+    return spans;
+}
+
+void TranslationEngine::ensureTerminology() const
+{
+    if (terminologyLoaded) {
+        return;
+    }
+    // 预热尚未完成时，第一次翻译在这里等待或直接加载
+    QMutexLocker locker(&terminologyMutex);
+    if (!terminologyLoaded) {
+        loadTerminology();
+        terminologyLoaded = true;
+    }
 }
 
-void TranslationEngine::loadTerminology()
+void TranslationEngine::loadTerminology() const
 {
     // 加载专业术语词典
-    medicalTerms = {
+    const QMap<QString, QString> medicalTerms = {
         {"myocardial infarction", "心肌梗死"},
         {"hypertension", "高血压"},
         {"antibiotics", "抗生素"},
@@ -169,7 +832,7 @@ void TranslationEngine::loadTerminology()
         {"treatment", "治疗"}
     };
 
-    legalTerms = {
+    const QMap<QString, QString> legalTerms = {
         {"plaintiff", "原告"},
         {"defendant", "被告"},
         {"jurisdiction", "司法管辖权"},
@@ -177,44 +840,33 @@ void TranslationEngine::loadTerminology()
         {"lawsuit", "诉讼"}
     };
 
-    technicalTerms = {
+    const QMap<QString, QString> technicalTerms = {
         {"algorithm", "算法"},
         {"blockchain", "区块链"},
         {"machine learning", "机器学习"},
         {"artificial intelligence", "人工智能"},
         {"cloud computing", "云计算"}
     };
-}
-
-QString TranslationEngine::applyTerminology(const QString& text)
-{
-    QString result = text;
-    QMap<QString, QString>* currentTerms = nullptr;
 
-    switch (currentDomain) {
-    case Domain::Medical:
-        currentTerms = &medicalTerms;
-        break;
-    case Domain::Legal:
-        currentTerms = &legalTerms;
-        break;
-    case Domain::Technical:
-        currentTerms = &technicalTerms;
-        break;
-    default:
-        return result;
+    // 没有词典的领域仍需保护数字、URL和代码
+    const auto general = std::make_shared<const PlaceholderMasker>();
+    for (Domain domain : { Domain::General, Domain::Academic, Domain::Business }) {
+        maskers.insert(domain, general);
     }
+    maskers.insert(Domain::Medical, std::make_shared<const PlaceholderMasker>(medicalTerms));
+    maskers.insert(Domain::Legal, std::make_shared<const PlaceholderMasker>(legalTerms));
+    maskers.insert(Domain::Technical, std::make_shared<const PlaceholderMasker>(technicalTerms));
+}
 
-    if (currentTerms) {
-        for (auto it = currentTerms->begin(); it != currentTerms->end(); ++it) {
-            // 使用正则表达式进行不区分大小写的替换
-            QRegularExpression regex("\\b" + QRegularExpression::escape(it.key()) + "\\b",
-                QRegularExpression::CaseInsensitiveOption);
-            result.replace(regex, it.value());
-        }
-    }
+const PlaceholderMasker& TranslationEngine::maskerFor(Domain domain) const
+{
+    ensureTerminology();
+    return *maskers.value(domain, maskers.value(Domain::General));
+}
 
-    return result;
+QString TranslationEngine::glossaryVersion(Domain domain) const
+{
+    return maskerFor(domain).glossaryVersion();
 }
 
 QString TranslationEngine::postProcessTranslation(const QString& text)
@@ -9,16 +9,17 @@
 #include <QEventLoop>
 #include <QThread>
 #include <QRegularExpression>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "SegmentStore.h"
+#include "SingleFlight.h"
+#include "TranslationBackend.h"
+#include "PlaceholderMasker.h"
+#include "TranslationCache.h"
 
-// 支持的专业领域
-enum class Domain {
-    General,
-    Medical,
-    Legal,
-    Technical,
-    Academic,
-    Business
-};
+class OrderedFileWriter;
 
 class TranslationEngine : public QObject
 {
@@ -32,40 +33,130 @@ public:
     void setDomain(Domain domain);
     void setSourceLanguage(const QString& lang);
     void setTargetLanguage(const QString& lang);
+    TranslationOptions currentOptions();
+
+    // 替换翻译后端，之后开始的请求使用新后端；默认为固定延迟的模拟后端
+    void setBackend(std::shared_ptr<TranslationBackend> backend);
+    // 同时进行的后端请求数上限（工作线程数）
+    void setMaxConcurrency(int threads);
+    // 在后台线程加载术语词典并预热翻译后端，完成后发出ready；
+    // 不调用时在第一次翻译前同步加载
+    void warmUp();
+
+    // 线程安全：一次后端请求翻译一批分段，供本地服务等调用方直接使用
+    // 后端重试后仍失败时返回空列表，并通过error给出原因
+    QStringList translateSegments(const QStringList& texts, const TranslationOptions& options,
+        QString* error = nullptr);
+    // 实际发往后端的分段数，以及因相同请求正在进行而被合并的分段数
+    quint64 dispatchedSegmentCount() const;
+    quint64 coalescedSegmentCount() const;
+    // 直接由缓存（包括预翻译结果）提供的分段数
+    quint64 cachedSegmentCount() const;
+    // 领域词典的版本，用于文档缓存的键
+    QString glossaryVersion(Domain domain) const;
+
+    // 文档分段存储，供分段对照视图使用
+    SegmentStore* segmentStore() const;
+    void loadDocument(QString text);
+    // 每个分段都有保留在内存中的译文时才能保存；否则通过error给出原因
+    bool canWriteDocument(QString* error = nullptr) const;
+    // 按分段顺序把译文流式写入文件，原子替换目标文件
+    bool writeDocument(const QString& filePath, QString* error = nullptr);
+    // 界面当前可见的分段范围，文档翻译优先处理这些分段及其下方一屏；线程安全
+    void setPriorityRange(int first, int last);
+
+    // 任务队列等在引擎之外调度的文档：原文放入任务自己的分段存储（计入内存预算），
+    // 与界面文档共用分段去重、请求划分、缓存和工作线程，不发出引擎的进度和完成信号
+    struct DocumentJob;
+    using DocumentJobPtr = std::shared_ptr<DocumentJob>;
+    // 译文按顺序写入writer；writer中已写入的分段不再翻译，用于暂停后继续
+    DocumentJobPtr prepareDocument(QString text, const TranslationOptions& options,
+        const std::shared_ptr<OrderedFileWriter>& writer);
+    // 在当前线程领取并翻译一个请求；没有可领取的请求、任务已失败或已取消时返回false
+    bool runNextDocumentUnit(const DocumentJobPtr& job);
+    // 失败原因，未失败时为空
+    static QString documentError(const DocumentJobPtr& job);
+    static void cancelDocument(const DocumentJobPtr& job);
+    // 在引擎的工作线程池中运行，与文档翻译共用线程
+    void startOnWorkerPool(std::function<void()> task, int priority);
+    int maxConcurrency() const;
+
+    // 以当前语言和领域设置低优先级预翻译已加载的文档，结果只进入缓存；
+    // 再次调用时放弃之前的预翻译，设置变化后据此按新设置重新开始
+    void startSpeculativeTranslation();
+    void cancelSpeculativeTranslation();
 
 public slots:
     void translateText(const QString& text);
     void translateBatch(const QStringList& texts);
+    // 指定outputPath时边翻译边按顺序写出，已写出的译文从内存中释放
+    void translateDocument(const QString& outputPath = QString());
+    // 一次处理原文，同时翻译为多种目标语言；outputPaths与targetLangs一一对应，可为空
+    void translateDocuments(const QStringList& targetLangs,
+        const QStringList& outputPaths = QStringList());
+    void cancelTranslation();
 
 signals:
     void translationProgress(int progress);
     void translationFinished(const QString& translatedText);
     void batchTranslationFinished(const QStringList& translatedTexts);
+    void documentTranslationFinished();
     void errorOccurred(const QString& error);
+    // warmUp的后台任务全部完成，从后台线程发出
+    void ready();
 
 private slots:
     void performMockTranslation(const QString& text);
 
 private:
-    QString performMockTranslationSync(const QString& text);
+    // cancelled被设置时不再重试，退避等待立即结束
+    bool dispatchSegments(const QList<QStringView>& texts, const TranslationOptions& options,
+        QStringList& results, QString& error, const std::atomic_bool* cancelled = nullptr);
+    bool performBackendRequest(const QStringList& texts, const TranslationOptions& options,
+        QStringList& results, QString& error, const std::atomic_bool* cancelled = nullptr);
+    static bool waitBeforeRetry(int attempt, const std::atomic_bool* cancelled);
+    std::shared_ptr<TranslationBackend> currentBackend();
+    DocumentJobPtr planDocument(SegmentStore* store, const QVector<TranslationOptions>& tracks,
+        const OrderedFileWriter* resumeFrom = nullptr);
+    void failDocument(DocumentJob& job, const QString& error);
+    void runDocumentWorker(const std::shared_ptr<DocumentJob>& job);
+    void runDocumentRequest(const std::shared_ptr<DocumentJob>& job, int track, int request);
+    bool storeDocumentTranslation(DocumentJob& job, int track, int index, const QString& translated);
+    void finishDocumentUnit(const std::shared_ptr<DocumentJob>& job);
     void performSingleTranslation(const QString& text);
     QString buildRequestData(const QString& text);
     QString parseTranslationResponse(const QByteArray& response);
     QStringList splitText(const QString& text, int maxLength = 4000);
+    static QVector<TextSpan> splitSpans(const QString& text, int maxLength);
     QString postProcessTranslation(const QString& text);
-    QString applyTerminology(const QString& text);
-    void loadTerminology();
+    const PlaceholderMasker& maskerFor(Domain domain) const;
+    void ensureTerminology() const;
+    void loadTerminology() const;
+    void finishWarmUp();
 
     QString apiKey;
     QString sourceLang;
     QString targetLang;
     Domain currentDomain;
     QMutex translationMutex;
+    std::shared_ptr<TranslationBackend> translationBackend;
+
+    SegmentStore* segments;
+    QThreadPool workerPool;
+    std::atomic_int priorityFirst;
+    std::atomic_int priorityLast;
+    SingleFlight inFlightSegments;
+    TranslationCache resultCache;
+    // 当前的文档翻译和预翻译；只在界面线程替换，取消时设置任务自己的标志
+    std::shared_ptr<DocumentJob> documentJob;
+    std::shared_ptr<DocumentJob> speculativeJob;
 
-    // 专业术语词典
-    QMap<QString, QString> medicalTerms;
-    QMap<QString, QString> legalTerms;
-    QMap<QString, QString> technicalTerms;
+    // 每个领域一个占位符替换器，第一次使用前加载，之后只读
+    mutable QMutex terminologyMutex;
+    mutable std::atomic_bool terminologyLoaded;
+    mutable QMap<Domain, std::shared_ptr<const PlaceholderMasker>> maskers;
+    QThreadPool warmUpPool;
+    std::atomic_int pendingWarmUps;
 };
 
 #endif
\ No newline at end of file
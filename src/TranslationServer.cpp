@@ -0,0 +1,456 @@
+﻿#include "TranslationServer.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // 合并窗口：第一个分段到达后最多等待这么久再组批
+    const int kBatchWindowMs = 5;
+    // 单个后端请求的上限，与引擎的请求大小一致
+    const int kMaxBatchSegments = 64;
+    const qsizetype kMaxBatchChars = 4000;
+    // 同时进行的后端请求数，超出后新分段在队列中等待
+    const int kMaxInFlightBatches = 8;
+    const qsizetype kMaxHeaderBytes = 16 * 1024;
+    const qsizetype kMaxBodyBytes = 16 * 1024 * 1024;
+
+    QByteArray statusText(int status)
+    {
+        switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 502: return "Bad Gateway";
+        default: return "Internal Server Error";
+        }
+    }
+
+    QByteArray errorBody(const QString& message)
+    {
+        return QJsonDocument(QJsonObject{ {"error", message} }).toJson(QJsonDocument::Compact);
+    }
+}
+
+// 一个HTTP请求，包含一个或多个待翻译分段
+struct TranslationServer::Request {
+    QPointer<QIODevice> socket;
+    TranslationOptions options;
+    QString optionsKey;
+    bool batch = false;
+    QStringList results;
+    QString error;
+    int remaining = 0;
+    // 客户端已断开：排队的分段被移除，进行中的结果被丢弃；在分发线程中读取
+    std::atomic_bool cancelled{ false };
+};
+
+TranslationServer::TranslationServer(TranslationEngine* engine, QObject* parent)
+    : QObject(parent)
+    , engine(engine)
+    , nextClientId(1)
+    , lastServedClient(0)
+    , inFlightBatches(0)
+{
+    batchTimer.setSingleShot(true);
+    batchTimer.setInterval(kBatchWindowMs);
+    dispatchPool.setMaxThreadCount(kMaxInFlightBatches);
+
+    connect(&batchTimer, &QTimer::timeout, this, &TranslationServer::dispatchBatches);
+    connect(&tcpServer, &QTcpServer::newConnection, this, &TranslationServer::onTcpConnection);
+    connect(&localServer, &QLocalServer::newConnection, this, &TranslationServer::onLocalConnection);
+}
+
+TranslationServer::~TranslationServer()
+{
+    dispatchPool.waitForDone();
+}
+
+bool TranslationServer::listenTcp(quint16 port)
+{
+    // 只监听本机地址
+    if (!tcpServer.listen(QHostAddress::LocalHost, port)) {
+        error = tcpServer.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TranslationServer::listenLocal(const QString& name)
+{
+    // 上次异常退出可能残留套接字文件
+    QLocalServer::removeServer(name);
+    if (!localServer.listen(name)) {
+        error = localServer.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString TranslationServer::errorString() const
+{
+    return error;
+}
+
+void TranslationServer::onTcpConnection()
+{
+    while (tcpServer.hasPendingConnections()) {
+        QTcpSocket* socket = tcpServer.nextPendingConnection();
+        connect(socket, &QTcpSocket::disconnected, this, &TranslationServer::onDisconnected);
+        addConnection(socket);
+    }
+}
+
+void TranslationServer::onLocalConnection()
+{
+    while (localServer.hasPendingConnections()) {
+        QLocalSocket* socket = localServer.nextPendingConnection();
+        connect(socket, &QLocalSocket::disconnected, this, &TranslationServer::onDisconnected);
+        addConnection(socket);
+    }
+}
+
+void TranslationServer::addConnection(QIODevice* socket)
+{
+    Connection connection;
+    connection.clientId = nextClientId++;
+    connections.insert(socket, connection);
+    connect(socket, &QIODevice::readyRead, this, &TranslationServer::onReadyRead);
+}
+
+void TranslationServer::onDisconnected()
+{
+    QIODevice* socket = qobject_cast<QIODevice*>(sender());
+    if (!socket) {
+        return;
+    }
+
+    // 移除该客户端排队的分段；已发出的批次完成后跳过其结果
+    Connection connection = connections.take(socket);
+    dropClientWork(connection);
+    socket->deleteLater();
+}
+
+void TranslationServer::dropClientWork(Connection& connection)
+{
+    clientQueues.remove(connection.clientId);
+    if (connection.pending) {
+        connection.pending->cancelled = true;
+        connection.pending.reset();
+    }
+}
+
+void TranslationServer::onReadyRead()
+{
+    QIODevice* socket = qobject_cast<QIODevice*>(sender());
+    if (!socket || !connections.contains(socket)) {
+        return;
+    }
+
+    Connection& connection = connections[socket];
+    if (connection.closing) {
+        // 出错后的剩余数据无法可靠分帧，直接丢弃
+        socket->readAll();
+        return;
+    }
+    connection.buffer += socket->readAll();
+    processBuffer(socket);
+}
+
+void TranslationServer::processBuffer(QIODevice* socket)
+{
+    Connection& connection = connections[socket];
+    if (connection.busy || connection.closing) {
+        // 同一连接上的请求按顺序处理
+        return;
+    }
+
+    const qsizetype headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (connection.buffer.size() > kMaxHeaderBytes) {
+            closeWithError(socket, 413, errorBody("请求头过大"));
+        }
+        return;
+    }
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    qsizetype contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        const qsizetype colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == "content-length") {
+            contentLength = line.mid(colon + 1).trimmed().toLongLong();
+        }
+    }
+
+    if (requestLine.size() < 2 || contentLength < 0 || contentLength > kMaxBodyBytes) {
+        closeWithError(socket, contentLength > kMaxBodyBytes ? 413 : 400, errorBody("无效的请求"));
+        return;
+    }
+
+    const qsizetype bodyStart = headerEnd + 4;
+    if (connection.buffer.size() < bodyStart + contentLength) {
+        return;
+    }
+
+    const QByteArray body = connection.buffer.mid(bodyStart, contentLength);
+    connection.buffer.remove(0, bodyStart + contentLength);
+    connection.busy = true;
+
+    handleRequest(socket, requestLine.at(0), requestLine.at(1), body);
+}
+
+void TranslationServer::handleRequest(QIODevice* socket, const QByteArray& method,
+    const QByteArray& path, const QByteArray& body)
+{
+    if (path == "/health") {
+        int queued = 0;
+        for (const auto& queue : clientQueues) {
+            queued += queue.size();
+        }
+        QJsonObject status{
+            {"status", "ok"},
+            {"clients", connections.size()},
+            {"queuedSegments", queued},
+            {"inFlightBatches", inFlightBatches},
+            {"dispatchedSegments", static_cast<qint64>(engine->dispatchedSegmentCount())},
+            {"coalescedSegments", static_cast<qint64>(engine->coalescedSegmentCount())}
+        };
+        sendResponse(socket, 200, QJsonDocument(status).toJson(QJsonDocument::Compact));
+        return;
+    }
+
+    if (path != "/translate" && path != "/translate/batch") {
+        sendResponse(socket, 404, errorBody("未知的接口"));
+        return;
+    }
+    if (method != "POST") {
+        sendResponse(socket, 405, errorBody("只支持POST"));
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonObject json = QJsonDocument::fromJson(body, &parseError).object();
+    if (parseError.error != QJsonParseError::NoError) {
+        sendResponse(socket, 400, errorBody(parseError.errorString()));
+        return;
+    }
+
+    auto request = std::make_shared<Request>();
+    request->socket = socket;
+    request->batch = path == "/translate/batch";
+
+    const TranslationOptions defaults = engine->currentOptions();
+    request->options.sourceLang = json.value("source").toString(defaults.sourceLang);
+    request->options.targetLang = json.value("target").toString(defaults.targetLang);
+    request->options.domain = defaults.domain;
+    if (json.contains("domain")) {
+        const QJsonValue domain = json.value("domain");
+        const double number = domain.toDouble(-1);
+        if (!domain.isDouble() || number != std::floor(number)
+            || number < static_cast<int>(Domain::General)
+            || number > static_cast<int>(Domain::Business)) {
+            sendResponse(socket, 400, errorBody("无效的domain"));
+            return;
+        }
+        request->options.domain = static_cast<Domain>(static_cast<int>(number));
+    }
+    request->optionsKey = QString("%1|%2|%3").arg(request->options.sourceLang,
+        request->options.targetLang).arg(static_cast<int>(request->options.domain));
+
+    QStringList texts;
+    if (request->batch) {
+        for (const QJsonValue& value : json.value("texts").toArray()) {
+            texts << value.toString();
+        }
+    }
+    else if (json.contains("text")) {
+        texts << json.value("text").toString();
+    }
+    else {
+        sendResponse(socket, 400, errorBody("缺少text字段"));
+        return;
+    }
+
+    request->results = QStringList(texts.size());
+    request->remaining = texts.size();
+    if (texts.isEmpty()) {
+        finishRequest(request);
+        return;
+    }
+
+    Connection& connection = connections[socket];
+    connection.pending = request;
+    QQueue<WorkItem>& queue = clientQueues[connection.clientId];
+    for (int i = 0; i < texts.size(); ++i) {
+        queue.enqueue({ request, i, texts.at(i) });
+    }
+
+    if (!batchTimer.isActive()) {
+        batchTimer.start();
+    }
+}
+
+void TranslationServer::dispatchBatches()
+{
+    while (inFlightBatches < kMaxInFlightBatches && !clientQueues.isEmpty()) {
+        // 从上次服务的客户端之后开始轮转
+        QList<quint64> order;
+        for (auto it = clientQueues.upperBound(lastServedClient); it != clientQueues.end(); ++it) {
+            order << it.key();
+        }
+        for (auto it = clientQueues.begin(); it != clientQueues.end() && it.key() <= lastServedClient; ++it) {
+            order << it.key();
+        }
+
+        // 以第一个客户端队首的语言设置为准，只合并设置相同的分段
+        const WorkItem& head = clientQueues[order.first()].head();
+        const QString key = head.request->optionsKey;
+        const TranslationOptions options = head.request->options;
+
+        QVector<WorkItem> items;
+        qsizetype chars = 0;
+        bool progressed = true;
+        while (progressed && items.size() < kMaxBatchSegments) {
+            progressed = false;
+            // 每轮每个客户端最多取一个分段
+            for (quint64 clientId : order) {
+                QQueue<WorkItem>& queue = clientQueues[clientId];
+                if (queue.isEmpty() || queue.head().request->optionsKey != key) {
+                    continue;
+                }
+                const qsizetype length = queue.head().text.length();
+                if (!items.isEmpty() && (chars + length > kMaxBatchChars
+                    || items.size() >= kMaxBatchSegments)) {
+                    continue;
+                }
+                chars += length;
+                items.append(queue.dequeue());
+                lastServedClient = clientId;
+                progressed = true;
+            }
+        }
+
+        for (auto it = clientQueues.begin(); it != clientQueues.end();) {
+            it = it.value().isEmpty() ? clientQueues.erase(it) : std::next(it);
+        }
+
+        QStringList texts;
+        texts.reserve(items.size());
+        for (const WorkItem& item : items) {
+            texts << item.text;
+        }
+
+        ++inFlightBatches;
+        dispatchPool.start([this, items, texts, options]() {
+            // 批次中的客户端都已断开时不再请求后端
+            const bool cancelled = std::all_of(items.begin(), items.end(),
+                [](const WorkItem& item) { return item.request->cancelled.load(); });
+            QString error;
+            QStringList results;
+            if (!cancelled) {
+                results = engine->translateSegments(texts, options, &error);
+            }
+            QMetaObject::invokeMethod(this, [this, items, results, error]() {
+                onBatchFinished(items, results, error);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void TranslationServer::onBatchFinished(const QVector<WorkItem>& items, const QStringList& results,
+    const QString& error)
+{
+    --inFlightBatches;
+    for (int i = 0; i < items.size(); ++i) {
+        const std::shared_ptr<Request>& request = items.at(i).request;
+        if (request->cancelled) {
+            continue;
+        }
+        if (results.isEmpty()) {
+            // 同一请求中任一分段失败，整个请求返回错误
+            request->error = error.isEmpty() ? QString("翻译失败") : error;
+        }
+        else {
+            request->results[items.at(i).index] = results.at(i);
+        }
+        if (--request->remaining == 0) {
+            finishRequest(request);
+        }
+    }
+
+    dispatchBatches();
+}
+
+void TranslationServer::finishRequest(const std::shared_ptr<Request>& request)
+{
+    if (request->cancelled || !request->socket) {
+        return;
+    }
+    auto it = connections.find(request->socket.data());
+    if (it != connections.end() && it->pending == request) {
+        it->pending.reset();
+    }
+    if (!request->error.isEmpty()) {
+        sendResponse(request->socket, 502, errorBody(request->error));
+        return;
+    }
+
+    QJsonObject response;
+    if (request->batch) {
+        response.insert("translations", QJsonArray::fromStringList(request->results));
+    }
+    else {
+        response.insert("translation", request->results.value(0));
+    }
+    sendResponse(request->socket, 200, QJsonDocument(response).toJson(QJsonDocument::Compact));
+}
+
+void TranslationServer::closeWithError(QIODevice* socket, int status, const QByteArray& body)
+{
+    Connection& connection = connections[socket];
+    connection.closing = true;
+    connection.buffer.clear();
+    dropClientWork(connection);
+    sendResponse(socket, status, body);
+
+    // 已写入的响应发送完后断开；断开时onDisconnected移除连接
+    if (auto* tcpSocket = qobject_cast<QTcpSocket*>(socket)) {
+        tcpSocket->disconnectFromHost();
+    }
+    else if (auto* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        localSocket->disconnectFromServer();
+    }
+}
+
+void TranslationServer::sendResponse(QIODevice* socket, int status, const QByteArray& body)
+{
+    QByteArray response;
+    response += "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n";
+    response += "Content-Type: application/json; charset=utf-8\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "\r\n";
+    response += body;
+    socket->write(response);
+
+    if (!connections.contains(socket)) {
+        return;
+    }
+    connections[socket].busy = false;
+
+    // 继续处理同一连接上已收到的后续请求
+    QPointer<QIODevice> guard(socket);
+    QMetaObject::invokeMethod(this, [this, guard]() {
+        if (guard && connections.contains(guard.data())) {
+            processBuffer(guard.data());
+        }
+    }, Qt::QueuedConnection);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+﻿#ifndef TRANSLATIONSERVER_H
+#define TRANSLATIONSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QQueue>
+#include <QPointer>
+#include <QTimer>
+#include <QThreadPool>
+#include <QTcpServer>
+#include <QLocalServer>
+#include <memory>
+#include "TranslationEngine.h"
+
+// 本地翻译服务：常驻一个TranslationEngine，通过本机HTTP端口或本地套接字
+// （Unix域套接字/Windows命名管道）提供接口：
+//   POST /translate        {"text": "...", "source": "en", "target": "zh", "domain": 0}
+//   POST /translate/batch  {"texts": ["...", ...], ...}
+//   GET  /health
+// 各客户端的分段在短时间窗口内合并成共享的后端请求，组批时按客户端轮转保证公平
+class TranslationServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TranslationServer(TranslationEngine* engine, QObject* parent = nullptr);
+    ~TranslationServer();
+
+    bool listenTcp(quint16 port);
+    bool listenLocal(const QString& name);
+    QString errorString() const;
+
+private slots:
+    void onTcpConnection();
+    void onLocalConnection();
+    void onReadyRead();
+    void onDisconnected();
+    void dispatchBatches();
+
+private:
+    struct Request;
+    struct WorkItem {
+        std::shared_ptr<Request> request;
+        int index;
+        QString text;
+    };
+    struct Connection {
+        quint64 clientId = 0;
+        QByteArray buffer;
+        bool busy = false;
+        // 协议错误后等待响应发完再断开，不再解析后续数据
+        bool closing = false;
+        // 正在翻译的请求，断开时据此取消
+        std::shared_ptr<Request> pending;
+    };
+
+    void addConnection(QIODevice* socket);
+    void processBuffer(QIODevice* socket);
+    void handleRequest(QIODevice* socket, const QByteArray& method, const QByteArray& path,
+        const QByteArray& body);
+    void enqueue(quint64 clientId, const std::shared_ptr<Request>& request);
+    void onBatchFinished(const QVector<WorkItem>& items, const QStringList& results,
+        const QString& error);
+    void finishRequest(const std::shared_ptr<Request>& request);
+    void sendResponse(QIODevice* socket, int status, const QByteArray& body);
+    // 请求无法分帧时（请求头过大、长度无效）回复错误并关闭连接，丢弃该客户端未完成的工作
+    void closeWithError(QIODevice* socket, int status, const QByteArray& body);
+    void dropClientWork(Connection& connection);
+
+    TranslationEngine* engine;
+    QTcpServer tcpServer;
+    QLocalServer localServer;
+    QString error;
+
+    QHash<QIODevice*, Connection> connections;
+    quint64 nextClientId;
+
+    // 每个客户端一个待翻译队列，组批时轮转取用
+    QMap<quint64, QQueue<WorkItem>> clientQueues;
+    quint64 lastServedClient;
+    QTimer batchTimer;
+    QThreadPool dispatchPool;
+    int inFlightBatches;
+};
+
+#endif
\ No newline at end of file
@@ -4,9 +4,231 @@
 #include <QLocale>
 #include <QStyleFactory>
 #include <QFontDatabase>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <cstring>
+#include "TranslationServer.h"
+#include "LoadTest.h"
+#include "BatchTranslator.h"
+#include "StartupTrace.h"
+
+// 服务模式：不创建窗口，常驻一个翻译引擎对外提供本地接口
+static int runServer(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("TranslationTool");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("YourCompany");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("专业文档翻译工具 - 本地翻译服务");
+    parser.addHelpOption();
+    parser.addOption({ "server", "以服务模式运行" });
+    parser.addOption({ "port", "本机HTTP端口（0表示不监听）", "port", "8765" });
+    parser.addOption({ "socket", "本地套接字名称（空表示不监听）", "name", "translationtool" });
+    parser.process(app);
+
+    TranslationEngine engine;
+    // 开始监听的同时在后台加载词典，第一个请求不必等待
+    engine.warmUp();
+    TranslationServer server(&engine);
+
+    const quint16 port = parser.value("port").toUShort();
+    if (port != 0 && !server.listenTcp(port)) {
+        qCritical() << "无法监听端口" << port << server.errorString();
+        return 1;
+    }
+
+    const QString socketName = parser.value("socket");
+    if (!socketName.isEmpty() && !server.listenLocal(socketName)) {
+        qCritical() << "无法监听本地套接字" << socketName << server.errorString();
+        return 1;
+    }
+
+    qInfo() << "翻译服务已启动，端口:" << port << "本地套接字:" << socketName;
+    return app.exec();
+}
+
+// 压测模式：用可配置的模拟后端翻译合成文档，输出各并发数和文档大小下的吞吐与延迟
+static int runLoadTest(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("TranslationTool");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("YourCompany");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("专业文档翻译工具 - 压力测试");
+    parser.addHelpOption();
+    parser.addOption({ "loadtest", "以压测模式运行" });
+    parser.addOption({ "sizes", "文档大小（字符数），逗号分隔", "list", "10000,100000,1000000" });
+    parser.addOption({ "concurrency", "并发数，逗号分隔", "list", "1,4,8,16" });
+    parser.addOption({ "latency-model", "延迟分布：fixed、uniform、normal、lognormal", "model", "fixed" });
+    parser.addOption({ "latency", "基准延迟（毫秒）", "ms", "100" });
+    parser.addOption({ "jitter", "抖动（毫秒）", "ms", "0" });
+    parser.addOption({ "per-char-us", "每字符附加处理时间（微秒）", "us", "0" });
+    parser.addOption({ "error-rate", "后端错误率（0-1）", "rate", "0" });
+    parser.addOption({ "rate-limit", "每秒请求数上限（0表示不限制）", "rps", "0" });
+    parser.addOption({ "repetition", "重复段落比例（0-1）", "ratio", "0.2" });
+    parser.addOption({ "scripts", "文字占比，如latin=0.6,cjk=0.3,cyrillic=0.1", "mix", "latin=1" });
+    parser.addOption({ "seed", "随机种子", "seed", "1" });
+    parser.addOption({ "csv", "同时把结果写入CSV文件", "path" });
+    parser.process(app);
+
+    LoadTestConfig config;
+
+    const QMap<QString, MockBackend::LatencyModel> models = {
+        {"fixed", MockBackend::LatencyModel::Fixed},
+        {"uniform", MockBackend::LatencyModel::Uniform},
+        {"normal", MockBackend::LatencyModel::Normal},
+        {"lognormal", MockBackend::LatencyModel::LogNormal}
+    };
+    const QString model = parser.value("latency-model").toLower();
+    if (!models.contains(model)) {
+        qCritical() << "未知的延迟分布" << model;
+        return 1;
+    }
+    config.backend.latencyModel = models.value(model);
+    config.backend.baseLatencyMs = parser.value("latency").toInt();
+    config.backend.jitterMs = parser.value("jitter").toInt();
+    config.backend.perCharLatencyUs = parser.value("per-char-us").toDouble();
+    config.backend.errorRate = parser.value("error-rate").toDouble();
+    config.backend.rateLimitPerSecond = parser.value("rate-limit").toInt();
+    config.backend.seed = parser.value("seed").toUInt();
+
+    config.corpus.repetitionRatio = parser.value("repetition").toDouble();
+    config.corpus.seed = config.backend.seed;
+    config.corpus.latinWeight = 0.0;
+    for (const QString& entry : parser.value("scripts").split(',', Qt::SkipEmptyParts)) {
+        const QString name = entry.section('=', 0, 0).trimmed().toLower();
+        const double weight = entry.section('=', 1).toDouble();
+        if (name == "latin") {
+            config.corpus.latinWeight = weight;
+        }
+        else if (name == "cjk") {
+            config.corpus.cjkWeight = weight;
+        }
+        else if (name == "cyrillic") {
+            config.corpus.cyrillicWeight = weight;
+        }
+        else {
+            qCritical() << "未知的文字类型" << name;
+            return 1;
+        }
+    }
+
+    for (const QString& size : parser.value("sizes").split(',', Qt::SkipEmptyParts)) {
+        if (size.toLongLong() > 0) {
+            config.documentSizes.append(size.toLongLong());
+        }
+    }
+    for (const QString& level : parser.value("concurrency").split(',', Qt::SkipEmptyParts)) {
+        if (level.toInt() > 0) {
+            config.concurrencyLevels.append(level.toInt());
+        }
+    }
+    if (config.documentSizes.isEmpty() || config.concurrencyLevels.isEmpty()) {
+        qCritical() << "文档大小和并发数不能为空";
+        return 1;
+    }
+
+    LoadTestHarness harness(config);
+    const QVector<LoadTestResult> results = harness.run();
+
+    QTextStream out(stdout);
+    out << LoadTestHarness::formatReport(results);
+    out.flush();
+
+    const QString csvPath = parser.value("csv");
+    if (!csvPath.isEmpty()) {
+        QFile file(csvPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qCritical() << "无法写入文件" << csvPath;
+            return 1;
+        }
+        file.write(LoadTestHarness::formatCsv(results).toUtf8());
+    }
+    return 0;
+}
+
+// 批处理模式：逐个翻译命令行给出的文件，未改动的文件直接使用文档缓存中的结果
+static int runBatch(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("TranslationTool");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("YourCompany");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("专业文档翻译工具 - 批量翻译");
+    parser.addHelpOption();
+    parser.addOption({ "batch", "以批处理模式运行" });
+    parser.addOption({ "source", "源语言代码", "lang", "en" });
+    parser.addOption({ "target", "目标语言代码", "lang", "zh" });
+    parser.addOption({ "domain", "专业领域（0通用 1医学 2法律 3技术 4学术 5商务）", "domain", "0" });
+    parser.addOption({ "output-dir", "输出目录", "dir", "." });
+    parser.addOption({ "cache-mb", "文档缓存的磁盘上限（MB）", "mb", "1024" });
+    parser.addPositionalArgument("files", "要翻译的文件", "files...");
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        qCritical() << "没有要翻译的文件";
+        return 1;
+    }
+
+    TranslationEngine engine;
+    engine.setSourceLanguage(parser.value("source"));
+    engine.setTargetLanguage(parser.value("target"));
+    engine.setDomain(static_cast<Domain>(parser.value("domain").toInt()));
+
+    DocumentCache cache(DocumentCache::defaultDirectory(),
+        parser.value("cache-mb").toLongLong() * 1024 * 1024);
+    BatchTranslator batch(&engine, &cache);
+
+    int failures = 0;
+    QObject::connect(&batch, &BatchTranslator::fileFinished,
+        [](const QString& input, const QString& output, bool fromCache, double elapsedMs) {
+            qInfo().noquote() << QString("%1 -> %2 (%3, %4 ms)").arg(input, output,
+                fromCache ? "缓存" : "翻译", QString::number(elapsedMs, 'f', 3));
+        });
+    QObject::connect(&batch, &BatchTranslator::fileFailed,
+        [&failures](const QString& input, const QString& error) {
+            ++failures;
+            qCritical().noquote() << input << "失败:" << error;
+        });
+    QObject::connect(&batch, &BatchTranslator::finished, &app, &QCoreApplication::quit);
+
+    batch.start(files, parser.value("output-dir"));
+    app.exec();
+    return failures == 0 ? 0 : 1;
+}
 
 int main(int argc, char* argv[])
 {
+    // 启动计时从这里开始
+    StartupTrace& trace = StartupTrace::instance();
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--server") == 0) {
+            return runServer(argc, argv);
+        }
+        if (std::strcmp(argv[i], "--loadtest") == 0) {
+            return runLoadTest(argc, argv);
+        }
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            return runBatch(argc, argv);
+        }
+        if (std::strcmp(argv[i], "--startup-trace") == 0) {
+            trace.setEnabled(true);
+        }
+    }
+
+    qint64 phaseStart = trace.elapsedNs();
     QApplication app(argc, argv);
 
     // 设置应用程序信息
@@ -26,9 +248,20 @@ int main(int argc, char* argv[])
     if (translator.load(QLocale::system(), "translation", "_", ":/i18n")) {
         app.installTranslator(&translator);
     }
+    trace.record("初始化QApplication", phaseStart, trace.elapsedNs() - phaseStart);
 
+    phaseStart = trace.elapsedNs();
     MainWindow window;
-    window.show();
+    trace.record("创建主窗口", phaseStart, trace.elapsedNs() - phaseStart);
+    {
+        StartupTrace::Scope scope("显示窗口");
+        window.show();
+    }
+
+    // 事件循环开始处理第一批事件时窗口即可响应操作
+    QTimer::singleShot(0, []() {
+        StartupTrace::instance().markInteractive();
+    });
 
     return app.exec();
 }
\ No newline at end of file